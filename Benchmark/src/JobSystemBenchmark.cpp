@@ -0,0 +1,164 @@
+
+// ---------------------------------------------------------------------------
+// ------ Job System Scaling Benchmark ---------------------------------------
+// ---------------------------------------------------------------------------
+//
+// Runs the same CPU-bound workloads with increasing worker counts and prints the speedup over a single thread.
+// Usage: Benchmark [maxThreads] [items], maxThreads defaults to the hardware thread count.
+
+
+// PCR
+#include "Core/JobSystem.h"
+
+// STD
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Stands in for parsing or converting one element, long enough that scheduling is not all that is measured
+    uint32_t Work(uint32_t item)
+    {
+        uint32_t x = item * 2654435761u + 1u;
+        for (int i = 0; i < 2000; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+        }
+        return x;
+    }
+
+    // Flat data parallelism, as in triangle conversion
+    uint64_t RunParallelFor(JobSystem* jobs, uint32_t threads, uint32_t items)
+    {
+        std::vector<uint32_t> results(items);
+        auto batch = [&results](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+                results[i] = Work(i);
+        };
+
+        if (jobs)
+            jobs->ParallelFor(items, 256, batch);
+        else
+            batch(0, items);
+
+        uint64_t checksum = 0;
+        for (uint32_t value : results)
+            checksum += value;
+        return checksum;
+    }
+
+    // Fan-out and fan-in through dependencies, as in loading several meshes and building caches from all of them
+    uint64_t RunDependencies(JobSystem* jobs, uint32_t threads, uint32_t items)
+    {
+        const uint32_t stages = 64;
+
+        // Splits [0, count) into parts ranges of nearly equal size, the last one ending at count
+        auto split = [](uint32_t count, uint32_t parts, uint32_t part)
+        {
+            return static_cast<uint32_t>(static_cast<uint64_t>(count) * part / parts);
+        };
+
+        std::atomic<uint64_t> checksum = 0;
+        auto work = [&checksum](uint32_t begin, uint32_t end)
+        {
+            uint64_t sum = 0;
+            for (uint32_t i = begin; i < end; ++i)
+                sum += Work(i);
+            checksum += sum;
+        };
+
+        if (!jobs)
+        {
+            work(0, items);
+            return checksum;
+        }
+
+        // Every stage fans out to a few parts per thread, so each thread count is kept busy and can steal to balance.
+        // All parts depend on the previous stage's join job.
+        uint32_t partCount = threads * 4;
+        JobSystem::JobHandle join;
+        for (uint32_t s = 0; s < stages; ++s)
+        {
+            uint32_t stageBegin = split(items, stages, s);
+            uint32_t stageSize = split(items, stages, s + 1) - stageBegin;
+
+            std::vector<JobSystem::JobHandle> parts;
+            for (uint32_t p = 0; p < partCount; ++p)
+            {
+                uint32_t begin = stageBegin + split(stageSize, partCount, p);
+                uint32_t end = stageBegin + split(stageSize, partCount, p + 1);
+                JobSystem::JobHandle dependencies[] = { join };
+                parts.push_back(jobs->Schedule([&work, begin, end]() { work(begin, end); }, dependencies));
+            }
+            join = jobs->Schedule([]() {}, parts);
+        }
+        jobs->Wait(join);
+        return checksum;
+    }
+
+    template<typename Workload>
+    double Measure(Workload workload, JobSystem* jobs, uint32_t threads, uint32_t items, uint64_t& checksum)
+    {
+        // Best of three, the first run also warms the workers up
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            checksum = workload(jobs, threads, items);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    template<typename Workload>
+    void Report(const char* name, Workload workload, uint32_t maxThreads, uint32_t items)
+    {
+        uint64_t expected = 0;
+        double serial = Measure(workload, nullptr, 1, items, expected);
+        std::printf("\n%s, %u items\n", name, items);
+        std::printf("%8s %12s %9s %11s %10s\n", "threads", "time (ms)", "speedup", "efficiency", "stolen");
+        std::printf("%8u %12.2f %9.2f %10.0f%% %10s\n", 1u, serial, 1.0, 100.0, "-");
+
+        // The thread calling Wait helps, so n threads are n - 1 workers and the caller
+        for (uint32_t threads = 2; threads <= maxThreads; threads = threads * 2 > maxThreads && threads < maxThreads ? maxThreads : threads * 2)
+        {
+            JobSystem jobs(threads - 1);
+            uint64_t checksum = 0;
+            double time = Measure(workload, &jobs, threads, items, checksum);
+            if (checksum != expected)
+            {
+                std::printf("Checksum mismatch with %u threads!\n", threads);
+                std::exit(1);
+            }
+
+            double speedup = serial / time;
+            std::printf("%8u %12.2f %9.2f %10.0f%% %10llu\n", threads, time, speedup, 100.0 * speedup / threads,
+                static_cast<unsigned long long>(jobs.GetStats().stolen));
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    uint32_t items = 1u << 18;
+    if (argc > 1)
+        maxThreads = std::max(static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)), 1u);
+    if (argc > 2)
+        items = std::max(static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)), 1u);
+
+    std::printf("Job system scaling on %u hardware threads, up to %u threads\n", std::thread::hardware_concurrency(), maxThreads);
+    Report("ParallelFor", RunParallelFor, maxThreads, items);
+    Report("Dependency chain", RunDependencies, maxThreads, items);
+    return 0;
+}
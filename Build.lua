@@ -10,8 +10,13 @@ workspace "PointCloudRenderer"
 
 OutputDir = "%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}"
 
+-- Shader compiler shipped with the Vulkan SDK, falls back to PATH when VULKAN_SDK is not set
+VulkanSDK = os.getenv("VULKAN_SDK")
+GlslangValidator = VulkanSDK and path.join(VulkanSDK, "Bin/glslangValidator") or "glslangValidator"
+
 group "Core"
 	include "Core/Build-Core.lua"
 group ""
 
-include "Sample/Build-Sample.lua"
\ No newline at end of file
+include "Sample/Build-Sample.lua"
+include "Benchmark/Build-Benchmark.lua"
\ No newline at end of file
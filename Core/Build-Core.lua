@@ -11,7 +11,12 @@ project "Core"
       "src/**.cpp",
       "vendor/glm/**.hpp",
       "vendor/glm/**.h",
-      "vendor/glm/**.inl"
+      "vendor/glm/**.inl",
+
+      -- GLSL sources, compiled to SPIR-V and embedded in Core at build time
+      "../Sample/shaders/*.comp",
+      "../Sample/shaders/*.vert",
+      "../Sample/shaders/*.frag"
     }
 
    includedirs
@@ -19,7 +24,8 @@ project "Core"
       "src",
       "include/Core",
       "external/vulkan/Include",
-      "vendor/glm/glm"
+      "vendor/glm/glm",
+      "%{cfg.objdir}/Shaders"
    }
 
    libdirs
@@ -35,6 +41,17 @@ project "Core"
    targetdir ("../bin/" .. OutputDir .. "/%{prj.name}")
    objdir ("../bin/int/" .. OutputDir .. "/%{prj.name}")
 
+   -- Each shader becomes a list of hex SPIR-V words named after the file, e.g. pointcloud.comp -> pointcloud_comp.inc,
+   -- which Shaders.cpp includes as the initializer of a constexpr array
+   filter "files:**.comp or **.vert or **.frag"
+       buildmessage "Compiling shader %{file.name}"
+       buildcommands
+       {
+           '{MKDIR} "%{cfg.objdir}/Shaders"',
+           '"' .. GlslangValidator .. '" -V -x "%{file.relpath}" -o "%{cfg.objdir}/Shaders/%{file.basename}_%{file.extension:sub(2)}.inc"'
+       }
+       buildoutputs { "%{cfg.objdir}/Shaders/%{file.basename}_%{file.extension:sub(2)}.inc" }
+
    filter "system:windows"
        systemversion "latest"
        defines { }
@@ -2,39 +2,87 @@
 
 // PCR
 #include "Device.h"
+#include "MemoryAllocator.h"
 #include "Triangle.h"
 
+// STD
+#include <cstddef>
+#include <memory>
+#include <source_location>
+#include <span>
+#include <vector>
+
 // VULKAN
 #include <vulkan/vulkan.h>
 
+// A buffer bound to a range of memory from the device's allocator
 class Buffer
 {
 public:
-    Buffer(VkDevice device,
-        VkPhysicalDevice physicalDevice,
+    // Buffers accessed from several queue families without ownership transfers list them all and are shared concurrently.
+    // The caller's location is registered as the creation site, std::make_shared would supply its own, so pass it through.
+    Buffer(Device* device,
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        const std::vector<uint32_t>& queueFamilies = {},
+        std::source_location site = std::source_location::current());
+
+    // Reads host memory the application owns in place, without copying it, see Device::SupportsHostMemoryImport.
+    // The pointer and size must be multiples of Device::GetHostPointerAlignment, and the memory has to stay allocated
+    // for the buffer's lifetime. The buffer is not mapped, the application writes its memory directly.
+    Buffer(Device* device,
+        const void* hostPointer,
         VkDeviceSize size,
         VkBufferUsageFlags usage,
-        VkMemoryPropertyFlags properties);
+        const std::vector<uint32_t>& queueFamilies = {},
+        std::source_location site = std::source_location::current());
 
     Buffer() {};
     ~Buffer();
 
     VkBuffer Get() const { return m_buffer; }
-    VkDeviceMemory GetMemory() const { return m_memory; }
+    VkDeviceMemory GetMemory() const { return m_allocation.memory; }
+    VkDeviceSize GetMemoryOffset() const { return m_allocation.offset; }
     VkDeviceSize GetSize() const { return m_size; }
 
+    // Host-visible memory stays mapped for the allocation's lifetime, Map returns that pointer
     void* Map() const;
-    void Unmap();
+
+    // The mapped memory viewed as elements of T, throws for memory that is not host visible
+    template<typename T = std::byte>
+    std::span<T> GetMapped() const { return std::span<T>(static_cast<T*>(Map()), static_cast<size_t>(m_size / sizeof(T))); }
+
+    // Writes through the mapping and flushes the written range
     void CopyData(const void* data, VkDeviceSize size);
+    void CopyData(VkDeviceSize offset, std::span<const std::byte> data);
+
+    // Needed around host access to memory that is not HOST_COHERENT and no-ops otherwise. Flush makes host writes
+    // available to the device, Invalidate makes device writes visible to the host. Ranges are in bytes from the start
+    // of the buffer and are widened to nonCoherentAtomSize.
+    void Flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+    void Invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+    bool IsCoherent() const { return m_coherent; }
+
+    // Memory compaction, see MemoryAllocator::ShouldMove. A move target is an empty buffer created like this one in a
+    // fuller block, nullptr when there is no room. Copying the contents needs TRANSFER_SRC and TRANSFER_DST usage.
+    bool ShouldMove() const { return m_allocator && m_allocator->ShouldMove(m_allocation); }
+    std::shared_ptr<Buffer> CreateMoveTarget(std::source_location site = std::source_location::current()) const;
 
 private:
     VkBuffer m_buffer = VK_NULL_HANDLE;
 
     VkDevice m_device = VK_NULL_HANDLE;
-    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
-    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    std::shared_ptr<MemoryAllocator> m_allocator;
+    std::shared_ptr<ResourceRegistry> m_registry;
+    MemoryAllocation m_allocation{};
     VkDeviceSize m_size = 0;
+    VkBufferUsageFlags m_usage = 0;
+    std::vector<uint32_t> m_queueFamilies;
 
-    uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    bool m_coherent = true;
+    VkDeviceSize m_atomSize = 1;
 
-};
\ No newline at end of file
+    void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies, const void* next);
+    VkMappedMemoryRange GetMappedRange(VkDeviceSize offset, VkDeviceSize size) const;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+// PCR
+#include "Buffer.h"
+#include "Device.h"
+
+// STD
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Collects writes to ranges of device-local buffers and records them once per frame. Overlapping and adjacent ranges
+// are merged, later writes winning, so each frame copies only the changed bytes, as one vkCmdCopyBuffer per buffer.
+// Merging costs time linear in the bytes written, whatever order the writes come in.
+// The data is staged in a persistently mapped buffer per slot, grown when a frame's changes do not fit, up to a limit
+// taken from the host-visible heap's budget. Changes beyond the limit are left for the following frames.
+// Write is thread safe, Record is called from the thread recording the frames.
+class BufferUpdater
+{
+public:
+	BufferUpdater(std::shared_ptr<Device> device, uint32_t slotCount);
+
+	// Copies the data. The buffer needs TRANSFER_DST usage and has to outlive the frame the write is recorded into.
+	void Write(const std::shared_ptr<Buffer>& buffer, VkDeviceSize offset, std::span<const std::byte> data);
+
+	bool HasPending() const;
+
+	// Moves writes not yet recorded for one buffer over to another of the same size, for buffers being replaced
+	void Retarget(const std::shared_ptr<Buffer>& from, const std::shared_ptr<Buffer>& to);
+
+	// Records the writes made so far into cmd, ordered after earlier reads and before later ones at the given stages,
+	// and before later transfers. Writes that do not fit the staging limit stay pending, at least one range is always
+	// recorded. Only call once the GPU has finished the slot's previous submission. Returns the bytes copied.
+	VkDeviceSize Record(VkCommandBuffer cmd, uint32_t slot, VkPipelineStageFlags readStages, VkAccessFlags readAccess);
+
+private:
+	// The bytes of one merged range, stored with spare room on both sides so a range growing in either direction,
+	// as with ascending or descending indices, is extended in place
+	struct PendingRange
+	{
+		std::vector<std::byte> storage;
+		size_t begin = 0;		// Offset of the range's first byte in storage
+		size_t size = 0;
+
+		std::byte* GetData() { return storage.data() + begin; }
+		const std::byte* GetData() const { return storage.data() + begin; }
+		// Extends the range by front bytes before it and back bytes after it, their contents are undefined
+		void Grow(size_t front, size_t back);
+	};
+
+	// Merged ranges of one buffer, keyed by their start offset and never overlapping or touching
+	struct PendingBuffer
+	{
+		std::shared_ptr<Buffer> buffer;
+		std::map<VkDeviceSize, PendingRange> ranges;
+	};
+
+	// Merges a write into the buffer's ranges, the caller holds the mutex
+	static void Merge(PendingBuffer& pending, VkDeviceSize offset, std::span<const std::byte> data);
+
+	std::shared_ptr<Device> m_device;
+	std::vector<std::shared_ptr<Buffer>> m_staging;
+	VkDeviceSize m_maxStagingSize = 0;		// Per slot, a single larger range still gets a buffer of its own size
+
+	mutable std::mutex m_mutex;
+	std::map<Buffer*, PendingBuffer> m_pending;
+};
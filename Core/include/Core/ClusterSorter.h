@@ -0,0 +1,55 @@
+#pragma once
+
+// PCR
+#include "Buffer.h"
+#include "Device.h"
+
+// STD
+#include <memory>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Orders point clusters (one compute workgroup each) front to back on the GPU and draws them
+// with one indirect draw per cluster, so early depth testing rejects most occluded points.
+class ClusterSorter
+{
+public:
+	ClusterSorter(std::shared_ptr<Device> device, std::shared_ptr<Buffer> clusterDepthBuffer, uint32_t particleCount, uint32_t clusterSize);
+	~ClusterSorter();
+
+	// Devices without multiDrawIndirect fall back to a single unordered draw
+	static bool IsSupported(Device* device);
+
+	// Record after the particle dispatch and outside a render pass. Cluster depths are bucketed within [depthMin, depthMax].
+	void Record(VkCommandBuffer cmd, float depthMin, float depthMax);
+
+	// Record inside the render pass with the particle vertex buffer bound
+	void Draw(VkCommandBuffer cmd);
+	// Draws clusters [firstCluster, firstCluster + clusterCount) of the sorted order, so the order is split across command buffers
+	void Draw(VkCommandBuffer cmd, uint32_t firstCluster, uint32_t clusterCount);
+
+	uint32_t GetClusterCount() const { return m_clusterCount; }
+
+private:
+	void Dispatch(VkCommandBuffer cmd, uint32_t pass, uint32_t groupCount, float depthMin, float depthMax);
+
+private:
+	std::shared_ptr<Device> m_device;
+	std::shared_ptr<Buffer> m_clusterDepthBuffer;
+	std::shared_ptr<Buffer> m_bucketBuffer;
+	std::shared_ptr<Buffer> m_drawCommandBuffer;
+
+	VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+	VkPipelineLayout m_layout = VK_NULL_HANDLE;
+	VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+	uint32_t m_particleCount;
+	uint32_t m_clusterSize;
+	uint32_t m_clusterCount;
+
+	const uint32_t BUCKET_COUNT = 1024;
+	const uint32_t WORK_GROUP_SIZE = 256;
+};
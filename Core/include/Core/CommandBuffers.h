@@ -1,22 +1,35 @@
 #pragma once
 
+// PCR
+#include "Device.h"
+
 // STD
+#include <memory>
 #include <vector>
 
 // VULKAN
 #include <vulkan/vulkan.h>
 
+// One primary command buffer per slot (frame in flight or swapchain image), each allocated from its own pool
+// so a slot's recording memory is recycled in bulk once the frame that last used it has completed.
 class CommandBuffers
 {
 public:
-	CommandBuffers(VkDevice device, VkCommandPool commandPool, VkRenderPass renderPass, const std::vector<VkFramebuffer>& framebuffers, VkExtent2D extent);
-	~CommandBuffers() {};
+	// Reusable buffers are recorded once and submitted many times, others are re-recorded for every submission
+	CommandBuffers(Device* device, uint32_t queueFamilyIndex, uint32_t count, bool reusable = false);
+	~CommandBuffers();
+
+	// Resets the slot's pool and begins its command buffer.
+	// Only call once the GPU has finished the slot's previous submission.
+	VkCommandBuffer Begin(uint32_t frame);
 
-	const std::vector<VkCommandBuffer>& Get() const { return m_commandBuffers; }
+	VkCommandBuffer Get(uint32_t frame) const { return m_commandBuffers[frame]; }
+	uint32_t GetFrameCount() const { return static_cast<uint32_t>(m_commandBuffers.size()); }
 
 private:
 	VkDevice m_device;
+	std::shared_ptr<ResourceRegistry> m_registry;
+	bool m_reusable;
+	std::vector<VkCommandPool> m_commandPools;
 	std::vector<VkCommandBuffer> m_commandBuffers;
-	const std::vector<VkFramebuffer>& m_framebuffers;
-	VkExtent2D m_extent;
-};
\ No newline at end of file
+};
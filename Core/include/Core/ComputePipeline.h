@@ -6,12 +6,18 @@
 class ComputePipeline
 {
 public:
-	ComputePipeline(std::shared_ptr<DescriptorPool> descriptorPool, std::shared_ptr<Device> device);
+	// Set 0 holds the particle buffers, set 1 the per-frame uniforms described by frameSetLayout
+	ComputePipeline(std::shared_ptr<DescriptorPool> descriptorPool, std::shared_ptr<Device> device, VkDescriptorSetLayout frameSetLayout);
 	~ComputePipeline();
 
 	VkPipeline Get() const { return m_pipeline; }
 	VkPipelineLayout GetLayout() const { return m_layout; }
 
+	// Folds groupCount workgroups over X, then Y and Z, within maxComputeWorkGroupCount. The grid may hold a few
+	// more groups than asked for, shaders linearize their workgroup index and skip those past the end.
+	// Throws when the count cannot be reached even with all three dimensions.
+	static VkExtent3D GetDispatchGrid(const Device* device, uint32_t groupCount);
+
 private:
 	std::shared_ptr<Device> m_device;
 
@@ -1,6 +1,11 @@
 #pragma once
 
+// PCR
+#include "MemoryAllocator.h"
+#include "ResourceRegistry.h"
+
 // STD
+#include <memory>
 #include <stdexcept>
 #include <set>
 #include <string>
@@ -9,6 +14,15 @@
 // VULKAN
 #include <vulkan/vulkan.h>
 
+// Memory available to this process in one heap
+struct MemoryHeapBudget
+{
+	VkDeviceSize size = 0;			// Total size of the heap
+	VkDeviceSize budget = 0;		// What the process can allocate before allocations may fail or evict
+	VkDeviceSize usage = 0;			// What the process currently holds
+	bool deviceLocal = false;
+};
+
 class Device
 {
 public:
@@ -19,17 +33,62 @@ public:
 	VkPhysicalDevice GetPhysicalDevice() const { return m_physicalDevice; }
 	VkQueue GetGraphicsQueue() const { return m_graphicsQueue; }
 	VkQueue GetPresentQueue() const { return m_presentQueue; }
+	VkQueue GetComputeQueue() const { return m_computeQueue; }
+	VkQueue GetTransferQueue() const { return m_transferQueue; }
 	VkSurfaceKHR GetSurface() const { return m_surface; }
+	const VkPhysicalDeviceProperties& GetProperties() const { return m_properties; }
+	const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return m_enabledFeatures; }
+	// Sub-allocates buffer memory, shared by every buffer of the device
+	const std::shared_ptr<MemoryAllocator>& GetAllocator() const { return m_allocator; }
+	// Every object created on the device, leaks are reported when the device is destroyed
+	const std::shared_ptr<ResourceRegistry>& GetRegistry() const { return m_registry; }
+
+	// True when the graphics queue can write timestamps for GPU frame timing
+	bool SupportsTimestamps() const { return m_timestampValidBits > 0 && m_properties.limits.timestampPeriod > 0.0f; }
+	uint32_t GetTimestampValidBits() const { return m_timestampValidBits; }
+
+	// Rendering several views in one render pass, VK_KHR_multiview is core since Vulkan 1.1
+	bool SupportsMultiview() const { return m_multiviewEnabled; }
+	uint32_t GetMaxMultiviewViewCount() const { return m_maxMultiviewViewCount; }
 
     uint32_t GetGraphicsFamilyIndex() const { return m_graphicsFamily; }
     uint32_t GetPresentFamilyIndex() const { return m_presentFamily; }
+    uint32_t GetComputeFamilyIndex() const { return m_computeFamily; }
+    uint32_t GetTransferFamilyIndex() const { return m_transferFamily; }
+
+	// True when a compute-capable family without graphics exists, so compute work can overlap rendering
+	bool HasAsyncCompute() const { return m_computeFamily != m_graphicsFamily; }
+
+	// True when a transfer-only family exists, otherwise transfers go through the graphics queue
+	bool HasTransferQueue() const { return m_transferFamily != m_graphicsFamily; }
+
+	// Integrated GPUs share system memory, device-local memory is then host visible and needs no staging copy
+	bool HasUnifiedMemory() const { return m_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || m_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU; }
+
+	// Budgets reported by VK_EXT_memory_budget when the extension is available. Without it the budget is the heap
+	// size and the usage is what the device's allocator holds, memory used by other processes goes unnoticed.
+	bool SupportsMemoryBudget() const { return m_memoryBudgetEnabled; }
+	std::vector<MemoryHeapBudget> GetMemoryBudgets() const;
+	// Budget of the heap buffers with the given memory properties are allocated from
+	MemoryHeapBudget GetBudget(VkMemoryPropertyFlags properties) const;
+	MemoryHeapBudget GetDeviceLocalBudget() const { return GetBudget(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT); }
+
+	// Host allocations imported as device memory through VK_EXT_external_memory_host, so the device reads them in place.
+	// Imported pointers and sizes must be multiples of the alignment.
+	bool SupportsHostMemoryImport() const { return m_hostMemoryImportEnabled; }
+	VkDeviceSize GetHostPointerAlignment() const { return m_hostPointerAlignment; }
+	// Memory types the host allocation can be imported as, 0 when it cannot be imported
+	uint32_t GetHostPointerMemoryTypes(const void* hostPointer) const;
 
 private:
+    bool IsExtensionSupported(const char* name) const;
 
     struct QueueFamilyIndices 
     {
         int graphicsFamily = -1;
         int presentFamily = -1;
+        int computeFamily = -1;     // Dedicated compute family if there is one, otherwise the graphics family
+        int transferFamily = -1;    // Transfer-only family if there is one, otherwise the graphics family
         bool IsComplete() const { return graphicsFamily >= 0 && presentFamily >= 0; }
     };
 
@@ -45,7 +104,23 @@ private:
     VkDevice m_device = VK_NULL_HANDLE;
     VkQueue m_graphicsQueue = VK_NULL_HANDLE;
     VkQueue m_presentQueue = VK_NULL_HANDLE;
+    VkQueue m_computeQueue = VK_NULL_HANDLE;
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
 
     uint32_t m_graphicsFamily = -1;
     uint32_t m_presentFamily = -1;
+    uint32_t m_computeFamily = -1;
+    uint32_t m_transferFamily = -1;
+
+    VkPhysicalDeviceProperties m_properties{};
+    VkPhysicalDeviceFeatures m_enabledFeatures{};
+    uint32_t m_timestampValidBits = 0;
+    bool m_multiviewEnabled = false;
+    bool m_memoryBudgetEnabled = false;
+    bool m_hostMemoryImportEnabled = false;
+    VkDeviceSize m_hostPointerAlignment = 0;
+    PFN_vkGetMemoryHostPointerPropertiesEXT m_getMemoryHostPointerProperties = nullptr;
+    std::shared_ptr<MemoryAllocator> m_allocator;
+    std::shared_ptr<ResourceRegistry> m_registry;
+    uint32_t m_maxMultiviewViewCount = 0;
 };
\ No newline at end of file
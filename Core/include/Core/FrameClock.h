@@ -0,0 +1,42 @@
+#pragma once
+
+// STD
+#include <chrono>
+#include <cstdint>
+
+// Wall-clock frame timing on a steady high-resolution timer. Animation time advances by the measured frame time,
+// by exactly the fixed step when one is set so runs are reproducible, and not at all while paused.
+class FrameClock
+{
+public:
+	FrameClock();
+
+	// Call once per rendered frame, before anything reads the time
+	void Tick();
+
+	// 0 advances by wall-clock time
+	void SetFixedStepMs(float stepMs) { m_fixedStepMs = stepMs > 0.0f ? stepMs : 0.0f; }
+	float GetFixedStepMs() const { return m_fixedStepMs; }
+	void SetPaused(bool paused) { m_paused = paused; }
+	bool IsPaused() const { return m_paused; }
+
+	// Animation time in seconds and its advance over the last tick
+	double GetTime() const { return m_time; }
+	float GetDeltaMs() const { return m_deltaMs; }
+	// Wall-clock time between the last two ticks, regardless of fixed step or pause
+	float GetRealDeltaMs() const { return m_realDeltaMs; }
+	// Number of ticks so far, the first frame is 1
+	uint64_t GetFrameIndex() const { return m_frameIndex; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point m_lastTick;
+	double m_time = 0.0;
+	float m_deltaMs = 0.0f;
+	float m_realDeltaMs = 0.0f;
+	uint64_t m_frameIndex = 0;
+
+	float m_fixedStepMs = 0.0f;
+	bool m_paused = false;
+};
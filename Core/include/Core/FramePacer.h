@@ -0,0 +1,26 @@
+#pragma once
+
+// STD
+#include <chrono>
+
+// Holds frame starts to a fixed interval by sleeping on the CPU until the predicted deadline of the next frame.
+// Starting a frame no earlier than needed keeps the input sampled for it fresh and avoids queueing frames ahead of the display.
+class FramePacer
+{
+public:
+	// 0 disables pacing
+	void SetTargetFrameTimeMs(float targetFrameTimeMs);
+	float GetTargetFrameTimeMs() const { return m_targetFrameTimeMs; }
+	bool IsEnabled() const { return m_targetFrameTimeMs > 0.0f; }
+
+	// Sleeps until the next deadline and returns the time slept in milliseconds.
+	// A frame that is already a whole interval late restarts the schedule from now instead of catching up.
+	float Wait();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	float m_targetFrameTimeMs = 0.0f;
+	Clock::duration m_interval{};
+	Clock::time_point m_deadline{};
+};
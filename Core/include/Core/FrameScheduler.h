@@ -0,0 +1,48 @@
+#pragma once
+
+// PCR
+#include "Device.h"
+
+// STD
+#include <memory>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Paces frames on a single timeline semaphore. Every frame gets a number, starting at 1, and its graphics submission
+// signals the timeline to that number, so "frame N is done" is a counter comparison rather than a fence per slot.
+// Anything owned by a frame slot is free again once the frame that last used it has completed.
+class FrameScheduler
+{
+public:
+	FrameScheduler(std::shared_ptr<Device> device, uint32_t framesInFlight);
+	~FrameScheduler();
+
+	// Waits until the frame that last used the next frame's slot has completed and returns the next frame's number.
+	// Calling it again without EndFrame returns the same number, e.g. when acquiring a swapchain image failed.
+	uint64_t BeginFrame();
+	// Marks the frame returned by BeginFrame as submitted, its submission must signal the timeline to that number
+	void EndFrame() { ++m_submittedFrame; }
+
+	uint64_t GetFrameNumber() const { return m_submittedFrame + 1; }
+	uint32_t GetSlot() const { return static_cast<uint32_t>(GetFrameNumber() % m_framesInFlight); }
+	uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+
+	// Last frame submitted to the GPU and last frame the GPU has finished, 0 before the first frame
+	uint64_t GetSubmittedFrame() const { return m_submittedFrame; }
+	uint64_t GetCompletedFrame() const;
+	bool IsFrameComplete(uint64_t frame) const { return GetCompletedFrame() >= frame; }
+
+	// Blocks until the GPU has finished the given frame, returns immediately for frame 0 or completed frames
+	void WaitForFrame(uint64_t frame) const;
+	void WaitIdle() const { WaitForFrame(m_submittedFrame); }
+
+	VkSemaphore GetTimeline() const { return m_timeline; }
+
+private:
+	std::shared_ptr<Device> m_device;
+
+	VkSemaphore m_timeline = VK_NULL_HANDLE;
+	uint32_t m_framesInFlight;
+	uint64_t m_submittedFrame = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+// PCR
+#include "Buffer.h"
+#include "Device.h"
+
+// STD
+#include <memory>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Must match MAX_VIEWS in the shaders reading the Frame uniform block
+constexpr uint32_t MAX_VIEWS = 8;
+
+// std140 layout of the Frame uniform block
+struct FrameUniformData
+{
+	glm::mat4 mvp[MAX_VIEWS];	// One camera per view, only the first is used without multiview
+	float time;
+	float padding[3];
+};
+
+// Per-slot uniform buffers for the values that change every frame, persistently mapped and written by the host.
+// A slot must not be rewritten until the GPU has finished the submission that last read it.
+class FrameUniforms
+{
+public:
+	FrameUniforms(std::shared_ptr<Device> device, uint32_t slotCount);
+	~FrameUniforms();
+
+	void Write(uint32_t slot, const FrameUniformData& data);
+
+	VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_descriptorSetLayout; }
+	const VkDescriptorSet* GetDescriptorSet(uint32_t slot) const { return &m_descriptorSets[slot]; }
+	uint32_t GetSlotCount() const { return static_cast<uint32_t>(m_buffers.size()); }
+
+private:
+	std::shared_ptr<Device> m_device;
+	std::vector<std::shared_ptr<Buffer>> m_buffers;
+
+	VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> m_descriptorSets;
+};
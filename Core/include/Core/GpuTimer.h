@@ -0,0 +1,34 @@
+#pragma once
+
+// PCR
+#include "Device.h"
+
+// STD
+#include <memory>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Measures GPU time of each frame slot with a pair of timestamp queries.
+// Results are read back without stalling once the frame that last used the slot has completed.
+class GpuTimer
+{
+public:
+	GpuTimer(std::shared_ptr<Device> device, uint32_t frameCount);
+	~GpuTimer();
+
+	void Begin(VkCommandBuffer cmd, uint32_t frame);
+	void End(VkCommandBuffer cmd, uint32_t frame);
+
+	// Returns false if the slot has not been written yet or its results are not available
+	bool GetElapsedMs(uint32_t frame, float& elapsedMs) const;
+
+private:
+	std::shared_ptr<Device> m_device;
+
+	VkQueryPool m_queryPool = VK_NULL_HANDLE;
+	std::vector<bool> m_written;
+	float m_timestampPeriod = 0.0f;
+	uint64_t m_timestampMask = 0;
+};
@@ -4,16 +4,19 @@
 #include "DescriptorPool.h"
 #include "Device.h"
 #include "RenderPass.h"
-#include "Swapchain.h"
 
 class GraphicsPipeline
 {
 public:
-	GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::shared_ptr<Swapchain> swapchain, std::shared_ptr<Device> device);
+	// Viewport and scissor are dynamic state, set them with SetViewport after binding.
+	// Camera matrices are read from the per-frame uniforms in set 0, described by frameSetLayout.
+	GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::shared_ptr<Device> device, VkDescriptorSetLayout frameSetLayout);
 	~GraphicsPipeline();
 
 	VkPipeline Get() const { return m_pipeline; }
 	VkPipelineLayout GetLayout() const { return m_layout; }
+
+	static void SetViewport(VkCommandBuffer cmd, VkExtent2D extent);
 private:
 	std::shared_ptr<Device> m_device;
 
@@ -0,0 +1,51 @@
+#pragma once
+
+// PCR
+#include "Device.h"
+#include "Image.h"
+#include "RenderPass.h"
+
+// STD
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Screen-space pull-push hole filling for splatting render passes. Gaps between sparse points are
+// filled from a color/depth pyramid of the nearest surface, so cost is bounded by the resolution
+// rather than the point count.
+class HoleFiller
+{
+public:
+	// levels: pyramid depth below full resolution, holes up to 2^levels pixels wide are filled
+	HoleFiller(std::shared_ptr<Device> device, std::shared_ptr<RenderPass> renderPass, uint32_t levels = 4);
+	~HoleFiller();
+
+	// The pyramid needs at least one level below full resolution, so targets have to be two pixels wide or high
+	static bool CanFill(VkExtent2D extent) { return std::max(extent.width, extent.height) >= 2; }
+
+	// Record after the splatting render pass ends and before RenderPass::Resolve
+	void Record(VkCommandBuffer cmd);
+
+private:
+	void Dispatch(VkCommandBuffer cmd, uint32_t mode, uint32_t level, const std::vector<VkExtent2D>& regions);
+
+private:
+	std::shared_ptr<Device> m_device;
+	std::shared_ptr<RenderPass> m_renderPass;
+
+	std::unique_ptr<Image> m_colorPyramid;
+	std::unique_ptr<Image> m_depthPyramid;
+	uint32_t m_levelCount;
+
+	VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> m_descriptorSets;	// One per fine level, binding it with the next coarser one
+	VkPipelineLayout m_layout = VK_NULL_HANDLE;
+	VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+	const float DEPTH_THRESHOLD = 0.02f;
+	const float MIN_COVERAGE = 0.5f;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+// PCR
+#include "MemoryAllocator.h"
+#include "ResourceRegistry.h"
+
+// STD
+#include <memory>
+#include <source_location>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// A device-local image with its own memory and views. The caller's location is registered as the creation site
+// of the image, its memory and its views; std::make_unique would supply its own, so pass the site through it.
+class Image
+{
+public:
+    Image(VkDevice device,
+        const MemoryAllocator& allocator,
+        std::shared_ptr<ResourceRegistry> registry,
+        VkExtent2D extent,
+        VkFormat format,
+        VkImageUsageFlags usage,
+        VkImageAspectFlags aspect,
+        uint32_t mipLevels = 1,
+        uint32_t arrayLayers = 1,
+        std::source_location site = std::source_location::current());
+
+    ~Image();
+
+    VkImage Get() const { return m_image; }
+    VkImageView GetView() const { return m_view; }
+    VkImageView GetMipView(uint32_t level) const { return m_mipViews[level]; }
+    uint32_t GetMipLevels() const { return m_mipLevels; }
+    uint32_t GetArrayLayers() const { return m_arrayLayers; }
+    VkExtent2D GetMipExtent(uint32_t level) const;
+    VkFormat GetFormat() const { return m_format; }
+    VkExtent2D GetExtent() const { return m_extent; }
+
+private:
+    VkImage m_image = VK_NULL_HANDLE;
+    VkImageView m_view = VK_NULL_HANDLE;
+    std::vector<VkImageView> m_mipViews;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    std::shared_ptr<ResourceRegistry> m_registry;
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    VkFormat m_format;
+    VkExtent2D m_extent;
+    uint32_t m_mipLevels;
+    uint32_t m_arrayLayers;
+
+    VkImageView CreateView(uint32_t baseMip, uint32_t mipCount, VkImageAspectFlags aspect, std::source_location site) const;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+// STD
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+struct JobSystemStats
+{
+	uint64_t executed = 0;		// Jobs run by workers or by threads helping in Wait
+	uint64_t stolen = 0;		// Jobs taken from another worker's deque
+};
+
+// Work-stealing job scheduler for CPU-side loading and preprocessing. Each worker owns a deque, popping its own jobs
+// newest first and stealing the oldest from other workers when it runs dry. Jobs run once all their dependencies
+// have finished, and threads waiting on a job run other jobs in the meantime, sleeping only when there are none.
+// An exception thrown by a job is rethrown from Wait, jobs depending on it still run.
+class JobSystem
+{
+public:
+	using JobFunction = std::function<void()>;
+
+	struct Job
+	{
+		JobFunction function;
+		std::atomic<uint32_t> pendingDependencies = 1;	// Starts with a guard held while the job is being scheduled
+		std::atomic<bool> done = false;
+		std::exception_ptr exception;					// Thrown by the function, rethrown by Wait; set before done
+		std::mutex mutex;
+		std::vector<std::shared_ptr<Job>> dependents;	// Guarded by mutex, scheduled when the job finishes
+	};
+	using JobHandle = std::shared_ptr<Job>;
+
+	// Instrumentation callbacks, invoked on the thread concerned. Worker index is -1 for threads that are not workers.
+	struct Hooks
+	{
+		std::function<void(int worker)> jobBegin;
+		std::function<void(int worker)> jobEnd;
+		std::function<void(int thief, int victim)> steal;
+		std::function<void(int worker)> idle;			// Before a worker sleeps for lack of work
+	};
+
+	// A worker count of 0 uses one worker per hardware thread besides the caller's
+	explicit JobSystem(uint32_t workerCount = 0);
+	// Outstanding jobs must have been waited on, queued jobs are dropped
+	~JobSystem();
+
+	JobHandle Schedule(JobFunction function, std::span<const JobHandle> dependencies = {});
+	// Rethrows the job's exception, if it threw
+	void Wait(const JobHandle& job);
+
+	// Calls function(begin, end) over [0, count) in batches of at most batchSize and returns once all have run,
+	// then rethrows the first exception a batch threw
+	void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+	// Set while no jobs are running
+	void SetHooks(const Hooks& hooks) { m_hooks = hooks; }
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+	// Index of the calling thread among this system's workers, -1 for other threads
+	int GetWorkerIndex() const;
+	JobSystemStats GetStats() const { return { m_executed.load(), m_stolen.load() }; }
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+		std::thread thread;
+	};
+
+	void WorkerMain(uint32_t index);
+	void Enqueue(JobHandle job);
+	JobHandle TryTakeJob(int worker);
+	void Execute(const JobHandle& job, int worker);
+
+private:
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	Hooks m_hooks;
+
+	std::atomic<uint32_t> m_queued = 0;
+	std::atomic<uint32_t> m_nextWorker = 0;		// Round robin target for jobs scheduled from other threads
+	std::atomic<bool> m_stop = false;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_progress;			// Jobs finished or queued, for threads sleeping in Wait
+	std::atomic<uint32_t> m_waiters = 0;
+
+	std::atomic<uint64_t> m_executed = 0;
+	std::atomic<uint64_t> m_stolen = 0;
+};
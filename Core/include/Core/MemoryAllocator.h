@@ -0,0 +1,113 @@
+#pragma once
+
+// STD
+#include <array>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+// PCR
+#include "ResourceRegistry.h"
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// A range of device memory handed out by MemoryAllocator
+struct MemoryAllocation
+{
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;				// Requested size, the reserved range may be larger
+	void* mapped = nullptr;				// Host pointer to offset, set for host-visible memory
+	uint32_t memoryType = 0;
+
+	// Owner bookkeeping
+	int32_t block = -1;					// -1 for dedicated allocations
+	uint32_t level = 0;
+};
+
+struct MemoryStats
+{
+	uint32_t blockCount = 0;			// Large allocations that are sub-allocated
+	uint32_t dedicatedCount = 0;		// Allocations too large or preferring their own VkDeviceMemory
+	uint32_t allocationCount = 0;		// Live allocations, sub-allocated and dedicated
+	VkDeviceSize reservedBytes = 0;		// Device memory held, blocks and dedicated allocations
+	VkDeviceSize usedBytes = 0;			// Reserved memory handed out, including rounding
+	VkDeviceSize requestedBytes = 0;	// Sum of the requested sizes
+};
+
+// Thrown when vkAllocateMemory runs out of device memory, which smaller requests may still fit in
+class OutOfDeviceMemoryError : public std::runtime_error
+{
+public:
+	OutOfDeviceMemoryError() : std::runtime_error("Out of device memory!") {}
+};
+
+// Reserves large blocks of device memory per memory type and sub-allocates them with a buddy allocator, so buffers
+// do not each cost a vkAllocateMemory call and count against maxMemoryAllocationCount. Ranges are powers of two aligned
+// to their size, which satisfies any buffer alignment requirement. Host-visible blocks stay mapped for their lifetime.
+// A block is released once it is empty, except for one empty block kept per memory type.
+class MemoryAllocator
+{
+public:
+	MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, std::shared_ptr<ResourceRegistry> registry, VkDeviceSize blockSize = 64ull * 1024 * 1024);
+	~MemoryAllocator();
+
+	// Dedicated memory is used when requested, or when the size exceeds half a block
+	MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool dedicated = false);
+	// Allocates for the buffer, honouring the driver's dedicated allocation preference, and binds it
+	MemoryAllocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+	// Imports the host allocation as dedicated memory of one of the memory types and binds the buffer to it. The memory
+	// is not mapped, the application writes the allocation directly. Freed like any other allocation.
+	MemoryAllocation ImportHostMemory(VkBuffer buffer, const void* hostPointer, VkDeviceSize size, uint32_t memoryTypeBits);
+	void Free(const MemoryAllocation& allocation);
+
+	// Compaction moves allocations out of blocks at most half used into fuller blocks of the same memory type, so the
+	// emptied blocks are released. ShouldMove tells whether such a block has room for the allocation, AllocateMoveTarget
+	// allocates there for the buffer and binds it. Move targets never reserve memory, an empty allocation means no room.
+	bool ShouldMove(const MemoryAllocation& allocation) const;
+	MemoryAllocation AllocateMoveTarget(VkBuffer buffer, const MemoryAllocation& source);
+
+	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+	const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_memoryProperties; }
+	MemoryStats GetStats() const;
+	// Device memory held in the heap, blocks and dedicated allocations
+	VkDeviceSize GetHeapReservedBytes(uint32_t heapIndex) const;
+
+private:
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		uint32_t memoryType = 0;
+		VkDeviceSize size = 0;
+		VkDeviceSize used = 0;
+		std::vector<std::set<VkDeviceSize>> freeLists;		// Free offsets per level, level 0 is the whole block
+	};
+
+	MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool dedicated, VkBuffer dedicatedBuffer);
+	VkDeviceMemory AllocateMemory(VkDeviceSize size, uint32_t memoryType, VkBuffer dedicatedBuffer, void** mapped);
+	void FreeMemory(VkDeviceMemory memory);
+	VkDeviceSize GetBlockSize(uint32_t memoryType) const;
+	uint32_t GetLevel(VkDeviceSize blockSize, VkDeviceSize size) const;
+	bool AllocateFromBlock(Block& block, uint32_t level, VkDeviceSize& offset);
+	bool IsMoveTarget(const Block& block, const Block& source, uint32_t level) const;
+
+private:
+	static constexpr VkDeviceSize MIN_ALLOCATION = 256;
+
+	VkDevice m_device;
+	std::shared_ptr<ResourceRegistry> m_registry;
+	VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+	VkDeviceSize m_blockSize;
+
+	mutable std::mutex m_mutex;
+	std::vector<std::unique_ptr<Block>> m_blocks;		// Released blocks leave an empty slot so indices stay stable
+	uint32_t m_dedicatedCount = 0;
+	uint32_t m_allocationCount = 0;
+	VkDeviceSize m_dedicatedBytes = 0;
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_dedicatedHeapBytes{};
+	VkDeviceSize m_requestedBytes = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+// PCR
+#include "Buffer.h"
+
+// STD
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Compacts allocator blocks while frames keep rendering. Registered buffers are moved out of sparsely used blocks into
+// fuller ones, a few per frame, until emptied blocks are released. Moves are recorded at a frame boundary ahead of the
+// frame's commands: the contents are copied, and the owner rebinds the replacement so the frame already draws from it.
+// The original, and whatever the owner retires along with it, is released once every frame that may read it completed.
+// Used from the thread recording the frames.
+class MemoryCompactor
+{
+public:
+	// Called with the replacement, the owner swaps it in wherever the buffer is bound
+	using Rebind = std::function<void(const std::shared_ptr<Buffer>& buffer)>;
+
+	MemoryCompactor(VkDeviceSize bytesPerFrame = 16ull * 1024 * 1024);
+
+	// The buffer may be moved while the owner holds it. Buffers whose contents are regenerated before they are read
+	// are moved without a copy, others need TRANSFER_SRC and TRANSFER_DST usage.
+	void Register(const std::shared_ptr<Buffer>& buffer, Rebind rebind, bool preserveContents = true);
+
+	bool HasMoves() const;
+
+	// Moves buffers until the frame's byte budget is spent, at least one when any should move. The copies are ordered
+	// after earlier reads and before later ones at the given stages. Returns the bytes moved.
+	VkDeviceSize Record(VkCommandBuffer cmd, uint64_t frame, VkPipelineStageFlags readStages, VkAccessFlags readAccess);
+
+	// Keeps the object alive until the frame being recorded has completed, for bindings replaced in a Rebind
+	void Retire(std::shared_ptr<void> object) { m_retired.emplace_back(m_frame, std::move(object)); }
+	// Releases what frames up to completedFrame retired
+	void Release(uint64_t completedFrame);
+
+private:
+	// Dropped once the owner releases the buffer
+	struct Entry
+	{
+		std::weak_ptr<Buffer> buffer;
+		Rebind rebind;
+		bool preserveContents = true;
+	};
+
+	VkDeviceSize m_bytesPerFrame;
+	uint64_t m_frame = 0;
+
+	std::vector<Entry> m_entries;
+	std::deque<std::pair<uint64_t, std::shared_ptr<void>>> m_retired;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 // PCR
+#include "JobSystem.h"
 #include "Triangle.h"
 
 // STD
@@ -14,7 +15,8 @@ class Mesh
 {
 public:
 	Mesh() {};
-	Mesh(const char* filepath);
+	// Faces are converted to triangles on the job system when one is given
+	Mesh(const char* filepath, JobSystem* jobs = nullptr);
 	~Mesh();
 
 	const std::vector<Triangle>& GetTriangles() const { return triangles; }
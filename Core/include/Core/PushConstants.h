@@ -1,12 +1,42 @@
 #pragma once
 
+// Time and camera matrices change every frame and live in FrameUniformData instead,
+// so recorded command buffers stay valid across frames
+
 struct ComputePushConstants
 {
-    float time;
     uint32_t numTriangles;
+    uint32_t numParticles;      // Across all chunks
+    uint32_t firstParticle;     // First particle of the chunk being generated
+    uint32_t chunkParticles;    // Particles in the chunk
+    uint32_t clusterOrder;      // Non-zero when clusters are depth-ordered: each workgroup samples a contiguous triangle range and writes its depth
+    uint32_t viewCount;         // Cameras in FrameUniformData, a cluster's depth is its nearest over all of them
 };
 
 struct GraphicsPushConstants
 {
-    glm::mat4 mvp;
+    float pointSize;
+    float pointScale;       // Pixels per unit at view depth 1 for density-adaptive point sizes, 0 to disable
+};
+
+struct ClusterOrderPushConstants
+{
+    uint32_t pass;
+    uint32_t numClusters;
+    uint32_t numParticles;
+    uint32_t clusterSize;
+    float depthMin;
+    float depthMax;
+};
+
+struct HoleFillPushConstants
+{
+    uint32_t mode;
+    uint32_t level;
+    uint32_t fineWidth;
+    uint32_t fineHeight;
+    uint32_t coarseWidth;
+    uint32_t coarseHeight;
+    float depthThreshold;
+    float minCoverage;
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+// STD
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// State changes sent from the thread handling window events to the render thread
+struct RenderCommand
+{
+	enum class Type
+	{
+		CameraDistance,		// value holds the new distance
+		Resize,				// width and height hold the window's new drawable size, the swapchain is recreated after the next present
+		Quit,				// The render thread finishes its current frame and exits
+		PresentPolicy,		// option holds the new PresentPolicy, applied by recreating the swapchain
+		FramePacing,		// value holds the target frame time in milliseconds, 0 disables pacing
+		FixedStep,			// value holds the animation step per frame in milliseconds, 0 follows wall-clock time
+		Pause				// option is 1 to pause animation, 0 to resume
+	};
+
+	Type type = Type::Quit;
+	float value = 0.0f;
+	uint32_t option = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
+
+// Lock-free single producer, single consumer ring of render commands. Push is only called from the event thread
+// and Pop only from the render thread, neither ever blocks.
+class RenderCommandQueue
+{
+public:
+	// Returns false when the queue is full, the render thread is then behind by CAPACITY - 1 commands
+	bool Push(const RenderCommand& command)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t next = (head + 1) % CAPACITY;
+		if (next == m_tail.load(std::memory_order_acquire))
+			return false;
+
+		m_commands[head] = command;
+		m_head.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false when the queue is empty
+	bool Pop(RenderCommand& command)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == m_head.load(std::memory_order_acquire))
+			return false;
+
+		command = m_commands[tail];
+		m_tail.store((tail + 1) % CAPACITY, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static constexpr size_t CAPACITY = 256;
+
+	std::array<RenderCommand, CAPACITY> m_commands{};
+	// Kept on separate cache lines so the two threads do not contend on them
+	alignas(64) std::atomic<size_t> m_head{ 0 };	// Next slot written by the producer
+	alignas(64) std::atomic<size_t> m_tail{ 0 };	// Next slot read by the consumer
+};
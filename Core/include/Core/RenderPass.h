@@ -2,33 +2,82 @@
 
 // PCR
 #include "Device.h"
+#include "Image.h"
 #include "Swapchain.h"
 
 // STD
+#include <memory>
 #include <vector>
 
 // VULKAN
 #include <vulkan/vulkan.h>
 
+struct RenderPassSettings
+{
+	bool offscreen = false;		// Draw into an owned color target that Resolve() scales into the swapchain image
+	bool depth = false;			// Add a depth attachment for depth testing
+	bool splatting = false;		// Offscreen RGBA16F target holding color and view depth, left in GENERAL layout for hole filling
+	uint32_t viewCount = 1;		// Views rendered in one pass with multiview into layers of an offscreen target, tiled into the swapchain image
+};
+
 class RenderPass
 {
 public: 
-	RenderPass(Device* device, Swapchain* swapchain);
+	RenderPass(Device* device, Swapchain* swapchain, const RenderPassSettings& settings = {});
 	~RenderPass();
 
-	void Begin(VkCommandBuffer cmd, uint32_t imageIndex);
+	// Secondary contents are recorded into secondary command buffers that inherit GetFramebuffer(imageIndex)
+	void Begin(VkCommandBuffer cmd, uint32_t imageIndex, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+	void Resolve(VkCommandBuffer cmd, uint32_t imageIndex);
+
+	// Rebuilds only the framebuffers and offscreen targets for a recreated swapchain, keeping the render pass itself.
+	// Returns false without changes if the swapchain format differs, the render pass must then be recreated.
+	bool Resize(Swapchain* swapchain);
+
+	// Whether the device can blit between offscreen targets and the swapchain images
+	static bool SupportsOffscreen(Device* device, Swapchain* swapchain);
 	
 	VkRenderPass Get() const { return m_renderPass; }
 	const std::vector<VkFramebuffer>& GetFramebuffers() const { return m_framebuffers; }
+	VkFramebuffer GetFramebuffer(uint32_t imageIndex) const { return m_settings.offscreen ? m_framebuffers[0] : m_framebuffers[imageIndex]; }
+	bool IsOffscreen() const { return m_settings.offscreen; }
+	bool HasDepth() const { return m_settings.depth; }
+	const RenderPassSettings& GetSettings() const { return m_settings; }
+
+	// Only valid for offscreen render passes
+	Image* GetColorTarget() const { return m_colorTarget.get(); }
+
+	// Size of each view's target layer; the swapchain extent unless several views share it as tiles
+	VkExtent2D GetTargetExtent() const { return m_targetExtent; }
+
+	// Area of each target layer that is rendered; smaller than the target extent only when offscreen
+	void SetRenderExtent(VkExtent2D extent);
+	VkExtent2D GetRenderExtent() const { return m_renderExtent; }
 
 private:
 	void CreateRenderPass(VkFormat swapchainFormat);
+	VkFormat FindDepthFormat() const;
+	void UpdateExtents(VkExtent2D extent);
 	void CreateFramebuffers(const std::vector<VkImageView>& imageViews);
+	void DestroyFramebuffers();
+	VkRect2D GetViewTile(uint32_t view) const;
 
 private:
 	VkDevice m_device;
+	VkPhysicalDevice m_physicalDevice;
+	std::shared_ptr<MemoryAllocator> m_allocator;
+	std::shared_ptr<ResourceRegistry> m_registry;
 	VkRenderPass m_renderPass = VK_NULL_HANDLE;
 	std::vector<VkFramebuffer> m_framebuffers;
 	VkExtent2D m_extent;
+	VkExtent2D m_targetExtent;
+	VkExtent2D m_renderExtent;
+	uint32_t m_tileColumns = 1;
 	Swapchain* m_swapchain;
-};
\ No newline at end of file
+	VkFormat m_swapchainFormat;
+
+	RenderPassSettings m_settings;
+	std::unique_ptr<Image> m_colorTarget;
+	std::unique_ptr<Image> m_depthTarget;
+	VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
+};
@@ -2,16 +2,43 @@
 
 // PCR
 #include "Buffer.h"
+#include "BufferUpdater.h"
+#include "ClusterSorter.h"
+#include "CommandBuffers.h"
 #include "ComputePipeline.h"
 #include "DescriptorPool.h"
 #include "Device.h"
+#include "FrameClock.h"
+#include "FramePacer.h"
+#include "FrameScheduler.h"
+#include "FrameUniforms.h"
+#include "GpuTimer.h"
 #include "GraphicsPipeline.h"
+#include "HoleFiller.h"
 #include "Instance.h"
+#include "JobSystem.h"
+#include "MemoryCompactor.h"
 #include "Mesh.h"
+#include "RenderCommandQueue.h"
 #include "RenderPass.h"
+#include "RendererStats.h"
+#include "ResolutionScaler.h"
+#include "SecondaryCommandBuffers.h"
+#include "Shaders.h"
 #include "Swapchain.h"
+#include "UploadService.h"
 #include "Window.h"
 
+// STD
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
 class Renderer
 {
 public:
@@ -19,46 +46,241 @@ public:
 	~Renderer();
 
 	void LoadMesh(const char* modelPath);
+	// Draws the application's points, four floats each (xyz position, w point spacing), along with any particles
+	// generated from a loaded mesh. Where VK_EXT_external_memory_host allows, static points are read in place rather
+	// than copied, so the memory has to stay allocated until Shutdown. Dynamic points are always copied so UpdatePoints
+	// can change them. Set before Init.
+	void SetPoints(std::span<const float> points, bool dynamic = false) { m_points = points.first(points.size() - points.size() % 4); m_dynamicPoints = dynamic; }
+
+	// Replace dynamic points after Init, from any thread. Changes are merged until the next frame starts, which copies
+	// only the changed ranges. Points are given as in SetPoints, four floats each.
+	void UpdatePoints(uint32_t firstPoint, std::span<const float> points);
+	void UpdatePoints(std::span<const uint32_t> indices, std::span<const float> points);
 
     void Init();
 	void Run();
     void Shutdown();
 
+	// Renders on a dedicated thread until Quit, so window events are handled while the GPU is waited on.
+	// Call after Init, Run must not be called from elsewhere afterwards. Shutdown stops the thread.
+	void StartRenderThread();
+	// Safe to call from the event thread at any time. Returns false if the queue is full, the command can be posted again later.
+	bool Post(const RenderCommand& command) { return m_commands.Push(command); }
+	// Posts Quit, waiting for room in the queue if needed
+	void Quit();
+
+	// Clamped at Init so the particle buffers fit in the device-local memory budget. Set before Init.
 	void SetParticleCount(uint32_t count) { m_particleCount = count; }
+	// Share of the device-local heap's remaining budget the particle buffers may take, 0 to 1. Set before Init.
+	void SetMemoryBudgetShare(float share) { m_memoryBudgetShare = std::clamp(share, 0.0f, 1.0f); }
 	void SetRotationSpeed(float speed) { m_rotationSpeed = glm::radians(speed); }
+	// Frames the CPU may record ahead of the GPU, independent of the swapchain image count. Set before Init.
+	void SetMaxFramesInFlight(uint32_t count) { m_maxFramesInFlight = std::max(count, 1u); }
+	void SetShaderOverrideDirectory(const std::string& directory) { Shaders::SetOverrideDirectory(directory); }
+
+	// Renders offscreen at a resolution adapted to the GPU frame time and upscales into the swapchain. Set before Init.
+	void SetDynamicResolution(bool enabled, float targetFrameTimeMs = 16.6f) { m_dynamicResolution = enabled; m_resolutionScaler.SetTargetFrameTimeMs(targetFrameTimeMs); }
+
+	// Depth-tests points so hidden fragments are rejected early; front-to-back orders clusters on the GPU first. Set before Init.
+	void SetDepthTest(bool enabled, bool frontToBack = true) { m_depthTest = enabled; m_frontToBack = frontToBack; }
+
+	// Splats small depth-tested points and fills the gaps between them with a pull-push pass over fillLevels pyramid levels.
+	// Adaptive point size scales each point with its projected sample spacing. Set before Init.
+	void SetSplatting(bool enabled, uint32_t fillLevels = 4, bool adaptivePointSize = true) { m_splatting = enabled; m_fillLevels = fillLevels; m_adaptivePointSize = adaptivePointSize; }
+
+	// Renders viewCount cameras spaced evenly around the mesh in a single multiview pass, tiled across the window.
+	// The particles are generated once per frame and shared by every view. Set before Init.
+	void SetMultiview(uint32_t viewCount) { m_viewCount = viewCount; }
+	// Places view index at eye looking at target instead of its spot on the orbit, from any thread.
+	// Both are in the mesh's space, which stays centred on the origin.
+	void SetViewCamera(uint32_t index, const glm::vec3& eye, const glm::vec3& target);
+	// Returns view index to its spot on the orbit, from any thread
+	void ResetViewCamera(uint32_t index);
+
+	// Records one command buffer per swapchain image once and resubmits it, re-recording only when the render extent
+	// or the distance of the cameras from the mesh change. Time and camera matrices are written to mapped uniforms each frame. Set before Init.
+	void SetPrerecordedCommands(bool enabled) { m_prerecordCommands = enabled; }
+
+	// Generates particles on a dedicated compute queue when the device has one, overlapping the next frame's
+	// generation with the current frame's rendering. Not combined with prerecorded commands. Set before Init.
+	void SetAsyncCompute(bool enabled) { m_asyncCompute = enabled; }
+
+	// Selects the present mode and swapchain image count. Set before Init, at runtime post RenderCommand::Type::PresentPolicy.
+	void SetPresentPolicy(PresentPolicy policy) { m_presentPolicy = policy; }
+
+	// Sleeps before each frame so frames start targetFrameTimeMs apart, 0 disables.
+	// Set before Init, at runtime post RenderCommand::Type::FramePacing.
+	void SetFramePacing(float targetFrameTimeMs) { m_framePacer.SetTargetFrameTimeMs(targetFrameTimeMs); }
+
+	// Advances animation by exactly stepMs per frame for reproducible runs, 0 follows wall-clock time.
+	// Set before Init, at runtime post RenderCommand::Type::FixedStep.
+	void SetFixedTimeStep(float stepMs) { m_frameClock.SetFixedStepMs(stepMs); }
+	// Freezes animation while frames keep rendering. Set before Init, at runtime post RenderCommand::Type::Pause.
+	void SetPaused(bool paused) { m_frameClock.SetPaused(paused); }
+
+	// Splits the particle draw into drawBatches secondary command buffers recorded in parallel on the job system,
+	// each thread into its own command pool. Not combined with prerecorded commands. Set before Init.
+	void SetParallelRecording(uint32_t drawBatches) { m_drawBatches = std::max(drawBatches, 1u); }
+
+	// Moves point and particle buffers out of sparsely used memory blocks, at most bytesPerFrame per frame, so blocks
+	// left behind by released buffers are given back to the device. Particles stay in place with async compute. Set before Init.
+	void SetMemoryCompaction(bool enabled, VkDeviceSize bytesPerFrame = 16ull * 1024 * 1024) { m_memoryCompaction = enabled; m_compactionBytesPerFrame = bytesPerFrame; }
+
+	// Stats of the last presented frame, safe to call from any thread while the render thread runs
+	RendererStats GetStats() const { std::lock_guard<std::mutex> lock(m_statsMutex); return m_publishedStats; }
+	// Shared by mesh loading and any other CPU-side preprocessing
+	const std::shared_ptr<JobSystem>& GetJobSystem() const { return m_jobSystem; }
 private:
+	// A contiguous range of particles stored in its own buffers, small enough to bind as one storage buffer.
+	// Each chunk is generated by its own dispatch and drawn with its own vertex buffer binding.
+	struct ParticleChunk
+	{
+		std::shared_ptr<Buffer> particles;
+		std::shared_ptr<Buffer> clusterDepths;
+		std::shared_ptr<DescriptorPool> descriptorPool;
+		std::shared_ptr<ClusterSorter> clusterSorter;		// Orders the chunk's clusters, chunks are drawn in sequence
+		uint32_t firstParticle = 0;
+		uint32_t particleCount = 0;
+	};
+
+	// Particle buffers and everything bound to them. Async compute double-buffers them so one set is
+	// generated on the compute queue while the other is drawn.
+	struct ParticleSet
+	{
+		std::vector<ParticleChunk> chunks;
+		VkSemaphore generated = VK_NULL_HANDLE;		// Compute queue to graphics queue
+		uint64_t drawnFrame = 0;					// Frame that last drew the set, regenerating waits for it on the timeline
+	};
+
+	// A range of the application's points, imported in place or copied to device-local memory
+	struct PointRange
+	{
+		std::shared_ptr<Buffer> buffer;
+		uint32_t firstPoint = 0;
+		uint32_t pointCount = 0;
+	};
+
     void RecreateSwapchain();
+    void ReleaseRetiredSwapchains();
+    void CreateImageSemaphores();
+    void DestroyImageSemaphores();
+    void CreateFrameSlots();
+    void UpdateFrameTiming(uint32_t slot);
+    void WriteFrameUniforms(uint32_t slot);
+    void ClampParticleCount();
+    void CreateParticleSets();
+    void DestroyParticleSets();
+    UploadTicket CreatePointBuffers();
+    void RegisterCompaction();
+    void RecordParticles(VkCommandBuffer cmd, uint32_t slot, ParticleSet& particles);
+    void SubmitParticles(uint32_t slot, ParticleSet& particles);
+    void RecordFrame(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t slot, ParticleSet& particles);
+    void RecordDrawBatches(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t slot, ParticleSet& particles);
+    void RecordDraws(VkCommandBuffer cmd, uint32_t slot, ParticleSet& particles, uint32_t batch, uint32_t batchCount);
+    void RecordParticleBarriers(VkCommandBuffer cmd, ParticleSet& particles, bool release);
+    uint32_t GetParticleChunkCapacity() const;
+    void ProcessCommands();
+    void RenderThreadMain();
+    RenderPassSettings GetRenderPassSettings() const;
 
 private:
 	std::shared_ptr<Window> m_window;
+    std::shared_ptr<JobSystem> m_jobSystem;
     std::shared_ptr<Instance> m_instance;
     VkSurfaceKHR m_surface = VK_NULL_HANDLE;
     std::shared_ptr<Device> m_device;
     std::shared_ptr<Swapchain> m_swapChain;
+    // Replaced swapchains whose images may still be presented, destroyed once the frame numbered with them completes
+    std::vector<std::pair<uint64_t, std::shared_ptr<Swapchain>>> m_retiredSwapchains;
     std::shared_ptr<RenderPass> m_renderPass;
 	std::shared_ptr<CommandBuffers> m_commandBuffers;
-	std::shared_ptr<DescriptorPool> m_descriptorPool;
+	std::shared_ptr<CommandBuffers> m_imageCommandBuffers;
+	std::shared_ptr<CommandBuffers> m_computeCommandBuffers;
+	std::shared_ptr<SecondaryCommandBuffers> m_secondaryCommandBuffers;
 
 	std::shared_ptr<ComputePipeline> m_computePipeline;
 	std::shared_ptr<GraphicsPipeline> m_graphicsPipeline;
+	std::shared_ptr<GpuTimer> m_gpuTimer;
+	std::shared_ptr<HoleFiller> m_holeFiller;
+	std::shared_ptr<FrameUniforms> m_frameUniforms;
+	std::shared_ptr<FrameScheduler> m_frameScheduler;
+	std::shared_ptr<UploadService> m_uploadService;
 
     std::shared_ptr<Buffer> m_triangleBuffer = nullptr;
-    std::shared_ptr<Buffer> m_particleBuffer = nullptr;
+    std::vector<ParticleSet> m_particleSets;
+    std::span<const float> m_points;
+    bool m_dynamicPoints = false;
+    std::vector<PointRange> m_pointRanges;
+    std::shared_ptr<BufferUpdater> m_pointUpdater;
+    std::shared_ptr<CommandBuffers> m_updateCommandBuffers;
+    std::mutex m_pointMutex;		// Guards range buffers, which compaction replaces while UpdatePoints writes them
+    std::shared_ptr<MemoryCompactor> m_memoryCompactor;
+    uint32_t m_particleSetIndex = 0;
 
 	uint32_t m_currentFrame = 0;
+    uint32_t m_maxFramesInFlight = 2;
     uint32_t m_imageCount = 0;
+    // Per frame in flight
     std::vector<VkSemaphore> m_imageAvailable;
+    // Per swapchain image, presentation waits on them until the image is acquired again
 	std::vector<VkSemaphore> m_renderFinished;
-	std::vector<VkFence> m_inFlightFences;
-	std::vector<VkFence> m_imagesInFlight;
-
+	std::vector<uint64_t> m_imageFrames;		// Frame that last rendered to the image
 
     bool m_meshLoaded = false;
     Mesh m_mesh;
 	std::vector<Triangle> m_triangles;
+	float m_meshRadius = 1.0f;
+
+	// A camera placed by the application, views without one orbit the mesh at the camera distance
+	struct ViewCamera
+	{
+		glm::vec3 eye{ 0.0f };
+		glm::vec3 target{ 0.0f };
+		bool placed = false;
+	};
+	std::array<ViewCamera, MAX_VIEWS> m_viewCameras{};
+	std::mutex m_viewMutex;
+	glm::vec2 m_clusterDepthRange{ 0.0f };	// Nearest and farthest depth of the mesh over all views of the frame
 
     const uint32_t WORK_GROUP_SIZE = 256;
+    // Memory and object counts query the driver and take the allocator's and registry's locks, so they are only
+    // refreshed every this many frames
+    const uint64_t MEMORY_STATS_INTERVAL = 60;
+    // Bounds how long the render thread waits for a swapchain image before it checks for Quit again
+    const uint64_t ACQUIRE_TIMEOUT_NS = 100'000'000;
 
     uint32_t m_particleCount = 10000;
+    float m_memoryBudgetShare = 0.8f;
     float m_rotationSpeed = glm::radians(10.0f);
+
+    bool m_dynamicResolution = false;
+    bool m_depthTest = false;
+    bool m_frontToBack = true;
+    bool m_splatting = false;
+    uint32_t m_fillLevels = 4;
+    bool m_adaptivePointSize = true;
+    uint32_t m_viewCount = 1;
+    bool m_prerecordCommands = false;
+    bool m_asyncCompute = false;
+    uint32_t m_drawBatches = 1;
+    bool m_memoryCompaction = false;
+    VkDeviceSize m_compactionBytesPerFrame = 16ull * 1024 * 1024;
+    std::vector<bool> m_recorded;
+    VkExtent2D m_recordedExtent{};
+    glm::vec2 m_recordedDepthRange{ 0.0f };
+    ResolutionScaler m_resolutionScaler;
+    RendererStats m_stats;
+    RendererStats m_publishedStats;		// Copied from m_stats after each present
+    mutable std::mutex m_statsMutex;
+    PresentPolicy m_presentPolicy = PresentPolicy::LowLatency;
+    FramePacer m_framePacer;
+    FrameClock m_frameClock;
+
+    // State owned by the render thread, changed only through posted commands
+    RenderCommandQueue m_commands;
+    std::thread m_renderThread;
+    std::atomic<bool> m_quit = false;
+    float m_cameraDistance = 3.0f;
+    VkExtent2D m_windowExtent{};		// Drawable size last posted by the event thread, the window is not read here
+    bool m_framebufferResized = false;
 };
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+// PCR
+#include "Device.h"
+#include "MemoryAllocator.h"
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+struct RendererStats
+{
+    float gpuFrameTimeMs = 0.0f;    // Last measured GPU time of a frame, 0 if timestamps are unsupported
+    float renderScale = 1.0f;       // Internal resolution relative to the swapchain
+    VkExtent2D renderExtent{};      // Internal resolution in pixels
+    uint64_t submittedFrame = 0;    // Number of the last frame submitted to the GPU
+    uint64_t completedFrame = 0;    // Number of the last frame the GPU has finished, read from the frame timeline
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;   // Chosen by the present policy from what the surface supports
+    float pacingSleepMs = 0.0f;     // Time the last frame slept to meet its pacing deadline
+    float cpuFrameTimeMs = 0.0f;    // Wall-clock time between the starts of the last two frames
+    float animationTime = 0.0f;     // Seconds of animation, stops while paused
+    uint64_t frameIndex = 0;        // Frames rendered so far
+    MemoryStats memory;             // Buffer memory held by the device allocator, refreshed every 60 frames
+    MemoryHeapBudget deviceMemory;  // Budget and usage of the device-local heap, from VK_EXT_memory_budget when available, refreshed every 60 frames
+    uint32_t particleCount = 0;     // Particles generated per frame, after clamping to the memory budget
+    VkDeviceSize pointUpdateBytes = 0;  // Point data copied by the last frame's UpdatePoints changes
+    VkDeviceSize compactedBytes = 0;    // Buffer memory moved by the last frame's memory compaction
+    uint32_t liveObjects = 0;       // Vulkan objects alive on the device, refreshed every 60 frames, per type from ResourceRegistry::GetStats
+};
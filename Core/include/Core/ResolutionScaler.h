@@ -0,0 +1,37 @@
+#pragma once
+
+// STD
+#include <cstdint>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Chooses the internal render resolution from measured GPU frame times.
+// Fragment cost scales with pixel count, so the linear scale is adjusted by the
+// square root of the ratio between the frame-time budget and the measured average.
+class ResolutionScaler
+{
+public:
+	ResolutionScaler(float targetFrameTimeMs = 16.6f, float minScale = 0.5f, float maxScale = 1.0f, uint32_t adjustInterval = 8);
+	~ResolutionScaler() {};
+
+	// Feeds one GPU frame time; the scale only changes once every adjust interval
+	void Update(float gpuFrameTimeMs);
+
+	// Internal extent for the given output extent, never smaller than 1x1
+	VkExtent2D GetRenderExtent(VkExtent2D outputExtent) const;
+
+	float GetScale() const { return m_scale; }
+	float GetTargetFrameTimeMs() const { return m_targetFrameTimeMs; }
+	void SetTargetFrameTimeMs(float targetMs) { m_targetFrameTimeMs = targetMs; }
+
+private:
+	float m_targetFrameTimeMs;
+	float m_minScale;
+	float m_maxScale;
+	uint32_t m_adjustInterval;
+
+	float m_scale = 1.0f;
+	float m_accumulatedMs = 0.0f;
+	uint32_t m_sampleCount = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+// STD
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <source_location>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Live objects of one type
+struct ResourceTypeStats
+{
+	VkObjectType type = VK_OBJECT_TYPE_UNKNOWN;
+	uint32_t count = 0;
+	VkDeviceSize bytes = 0;			// Only buffers and device memory carry a size
+};
+
+// Tracks every Vulkan object created on a device, with its size and the source line that created it.
+// Objects are recorded where they are created and erased where they are destroyed, so whatever is still
+// recorded when the device is destroyed has leaked and is reported with its creation site.
+class ResourceRegistry
+{
+public:
+	template<typename Handle>
+	void Track(VkObjectType type, Handle handle, VkDeviceSize size = 0, std::source_location site = std::source_location::current())
+	{
+		TrackKey(type, ToKey(handle), size, site);
+	}
+
+	template<typename Handle>
+	void Untrack(VkObjectType type, Handle handle)
+	{
+		UntrackKey(type, ToKey(handle));
+	}
+
+	std::vector<ResourceTypeStats> GetStats() const;
+	uint32_t GetLiveCount() const;
+
+	// Writes every live object to stderr and returns how many there are
+	uint32_t ReportLeaks() const;
+
+	static const char* GetTypeName(VkObjectType type);
+
+private:
+	struct Entry
+	{
+		VkDeviceSize size = 0;
+		const char* file = nullptr;
+		uint32_t line = 0;
+	};
+
+	// Non-dispatchable handles are pointers on 64-bit platforms and integers elsewhere
+	template<typename Handle>
+	static uint64_t ToKey(Handle handle)
+	{
+		if constexpr (std::is_pointer_v<Handle>)
+			return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+		else
+			return static_cast<uint64_t>(handle);
+	}
+
+	void TrackKey(VkObjectType type, uint64_t handle, VkDeviceSize size, const std::source_location& site);
+	void UntrackKey(VkObjectType type, uint64_t handle);
+
+private:
+	mutable std::mutex m_mutex;
+	// Handles are only unique per type
+	std::map<std::pair<VkObjectType, uint64_t>, Entry> m_objects;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+// PCR
+#include "Device.h"
+
+// STD
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Secondary command buffers recorded by several threads at once. Every thread that records gets its own pool per
+// frame slot, keyed by its thread id, since a pool may only be used by one thread at a time. Any thread may run a
+// recording job, including one that helps while waiting on the job system. Buffers are allocated on demand and kept for reuse.
+class SecondaryCommandBuffers
+{
+public:
+	SecondaryCommandBuffers(Device* device, uint32_t queueFamilyIndex, uint32_t frameCount);
+	~SecondaryCommandBuffers();
+
+	// Resets every thread's pool of the slot.
+	// Only call once the GPU has finished the slot's previous submission and no thread is recording into it.
+	void Reset(uint32_t frame);
+
+	// Begins the next command buffer of the calling thread's pool, continuing the inherited render pass
+	VkCommandBuffer Begin(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance);
+
+private:
+	struct Pool
+	{
+		VkCommandPool pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> buffers;
+		uint32_t used = 0;
+	};
+
+	// The calling thread's pool of the slot, its pools are created the first time it records
+	Pool& GetThreadPool(uint32_t frame);
+
+	VkDevice m_device;
+	std::shared_ptr<ResourceRegistry> m_registry;
+	uint32_t m_queueFamilyIndex;
+	uint32_t m_frameCount;
+
+	std::mutex m_mutex;		// Guards the map, each pool is only used by its own thread
+	std::unordered_map<std::thread::id, std::vector<Pool>> m_pools;		// One pool per frame slot for each thread
+};
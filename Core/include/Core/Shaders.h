@@ -0,0 +1,33 @@
+#pragma once
+
+// STD
+#include <cstdint>
+#include <span>
+#include <string>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+struct ShaderSource
+{
+    const char* name;                   // SPIR-V file name looked up in the override directory
+    std::span<const uint32_t> code;     // SPIR-V embedded at build time
+};
+
+namespace Shaders
+{
+    extern const ShaderSource PointCloudComp;
+    extern const ShaderSource PointCloudVert;
+    extern const ShaderSource PointCloudFrag;
+    extern const ShaderSource PointCloudOrder;
+    extern const ShaderSource PointCloudSplatFrag;
+    extern const ShaderSource PointCloudFill;
+    extern const ShaderSource PointCloudMultiviewVert;
+
+    // When set, shader modules are created from "<directory>/<name>" instead of the embedded SPIR-V.
+    // Intended for iterating on shaders without rebuilding Core; pass an empty string to disable.
+    void SetOverrideDirectory(const std::string& directory);
+    const std::string& GetOverrideDirectory();
+
+    VkShaderModule CreateModule(VkDevice device, const ShaderSource& shader);
+}
@@ -2,7 +2,6 @@
 
 // PCR
 #include "Device.h"
-#include "Window.h"
 
 // STD
 #include <vector>
@@ -10,16 +9,31 @@
 // VULKAN
 #include <vulkan/vulkan.h>
 
+// How presentation trades throughput, latency and power
+enum class PresentPolicy : uint32_t
+{
+	Throughput,		// Immediate where supported, frames are never held back by the display and may tear
+	LowLatency,		// Mailbox where supported, the newest finished frame is shown at each vertical blank
+	PowerSaving		// FIFO with as few images as allowed, the GPU renders at most at the refresh rate
+};
+
 class Swapchain
 {
 public:
-	Swapchain(Device* device, Window* window);
+	// Passing the swapchain being replaced lets the driver hand its resources over; it is retired but must outlive
+	// the frames still presenting from it. windowExtent is the window's drawable size in pixels, used when the
+	// surface leaves the extent to the swapchain.
+	Swapchain(Device* device, VkExtent2D windowExtent, Swapchain* oldSwapchain = nullptr, PresentPolicy policy = PresentPolicy::LowLatency);
 	~Swapchain();
 
 	VkSwapchainKHR Get() const { return m_swapchain; }
+	const std::vector<VkImage>& GetImages() const { return m_images; }
 	const std::vector<VkImageView>& GetImageViews() const { return m_imageViews; }
 	VkFormat GetFormat() const { return m_format; }
 	VkExtent2D GetExtent() const { return m_extent; }
+	VkImageUsageFlags GetUsage() const { return m_usage; }
+	VkPresentModeKHR GetPresentMode() const { return m_presentMode; }
+	PresentPolicy GetPresentPolicy() const { return m_policy; }
 
 private:
     struct SwapchainSupportDetails 
@@ -31,18 +45,23 @@ private:
 
     SwapchainSupportDetails QuerySwapchainSupport(VkPhysicalDevice device);
     VkSurfaceFormatKHR ChooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-    VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes);
+    VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes) const;
+    uint32_t ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities) const;
     VkExtent2D ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t width, uint32_t height);
-    void CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphicsFamily, uint32_t presentFamily);
+    void CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphicsFamily, uint32_t presentFamily, VkSwapchainKHR oldSwapchain);
     void CreateImageViews();
 
 private:
     VkPhysicalDevice m_physicalDevice;
     VkDevice m_device;
+    std::shared_ptr<ResourceRegistry> m_registry;
     VkSurfaceKHR m_surface;
     VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
     VkFormat m_format;
     VkExtent2D m_extent;
+    VkImageUsageFlags m_usage = 0;
+    PresentPolicy m_policy;
+    VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
     std::vector<VkImage> m_images;
     std::vector<VkImageView> m_imageViews;
@@ -0,0 +1,74 @@
+#pragma once
+
+// PCR
+#include "Buffer.h"
+#include "Device.h"
+
+// STD
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <source_location>
+#include <vector>
+
+// VULKAN
+#include <vulkan/vulkan.h>
+
+// Identifies an upload, complete once every copy it needed has finished on the GPU
+struct UploadTicket
+{
+	uint64_t id = 0;		// 0 for uploads that were written directly and are already complete
+};
+
+// Streams static data into device-local buffers through a persistently mapped staging ring, copied on the dedicated
+// transfer queue where there is one. Each copy is submitted with a fence that recycles its part of the ring.
+// On unified memory, device-local memory is host visible and buffers are written in place without staging.
+// Not thread safe, it is used from the thread submitting the frames since the transfer queue may be the graphics queue.
+class UploadService
+{
+public:
+	UploadService(std::shared_ptr<Device> device, VkDeviceSize stagingSize = 16ull * 1024 * 1024);
+	~UploadService();
+
+	// Creates a device-local buffer holding the data. The buffer is shared with the given queue families
+	// and the transfer family, so it needs no ownership transfer. Use it once the ticket has completed.
+	// The caller's location is registered as the buffer's creation site.
+	std::shared_ptr<Buffer> CreateBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage,
+		const std::vector<uint32_t>& queueFamilies, UploadTicket& ticket, std::source_location site = std::source_location::current());
+
+	// Copies the data into dst at dstOffset, larger uploads are split over several trips through the ring
+	UploadTicket Upload(Buffer& dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+	bool IsComplete(UploadTicket ticket);
+	void Wait(UploadTicket ticket);
+	void WaitIdle();
+
+private:
+	struct Submission
+	{
+		VkCommandBuffer cmd = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		VkDeviceSize begin = 0;			// Staging range the copy reads
+		VkDeviceSize end = 0;
+		uint64_t id = 0;
+	};
+
+	bool HasHostVisibleDeviceMemory() const;
+	VkDeviceSize ReserveStaging(VkDeviceSize size);
+	void RetireOldest();
+	void RetireCompleted();
+	Submission AcquireSubmission();
+
+private:
+	std::shared_ptr<Device> m_device;
+	std::shared_ptr<Buffer> m_staging;
+	uint8_t* m_stagingData = nullptr;
+	VkDeviceSize m_stagingHead = 0;
+
+	VkCommandPool m_commandPool = VK_NULL_HANDLE;
+	std::deque<Submission> m_pending;		// In submission order, so the oldest bounds the free part of the ring
+	std::vector<Submission> m_free;			// Command buffers and fences ready for reuse
+
+	uint64_t m_nextId = 1;
+	uint64_t m_completedId = 0;
+};
@@ -4,6 +4,7 @@
 #include <codecvt>
 #include <fstream>
 #include <locale>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -31,12 +32,12 @@ namespace Utils
         return buffer;
     }
 
-    static VkShaderModule CreateShaderModule(VkDevice device, const std::vector<char>& code)
+    static VkShaderModule CreateShaderModule(VkDevice device, std::span<const uint32_t> code)
     {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.codeSize = code.size_bytes();
+        createInfo.pCode = code.data();
 
         VkShaderModule shaderModule;
         if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
@@ -13,16 +13,25 @@ public:
 	~Window();
 
 	bool PollEvents();
+	// Sleeps until an event arrives or timeoutMs passes, then handles every pending event like PollEvents
+	bool WaitEvents(int timeoutMs);
 
 	SDL_Window* Get() const { return m_window; }
 
+	// Drawable size in pixels, updated while handling events. Only read it from the thread handling events.
 	uint32_t GetWidth() const { return m_width; }
 	uint32_t GetHeight() const { return m_height; }
+	// Refresh rate of the display showing the window, 60 if it cannot be queried
+	int GetRefreshRate() const;
 public:
 	bool FramebufferResized = false;
 
 	float CameraDistance = 3.0f;
 	float ZoomSpeed = 0.1f;
+private:
+	// Returns false on quit
+	bool HandleEvent(const SDL_Event& event);
+
 private:
 	uint32_t m_width = 1208;
 	uint32_t m_height = 720;
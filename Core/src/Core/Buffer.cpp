@@ -1,86 +1,208 @@
 #include "Buffer.h"
 
 // STD
+#include <algorithm>
+#include <cstring>
+#include <set>
 #include <stdexcept>
 
-Buffer::Buffer(VkDevice device,
-    VkPhysicalDevice physicalDevice,
+Buffer::Buffer(Device* device,
     VkDeviceSize size,
     VkBufferUsageFlags usage,
-    VkMemoryPropertyFlags properties)
-    : m_device(device), m_physicalDevice(physicalDevice), m_size(size)
+    VkMemoryPropertyFlags properties,
+    const std::vector<uint32_t>& queueFamilies,
+    std::source_location site)
+    : m_device(device->Get()), m_allocator(device->GetAllocator()), m_registry(device->GetRegistry()), m_size(size),
+    m_atomSize(std::max<VkDeviceSize>(device->GetProperties().limits.nonCoherentAtomSize, 1))
 {
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = size;
-    bufferInfo.usage = usage;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CreateBuffer(size, usage, queueFamilies, nullptr);
 
-    if (vkCreateBuffer(device, &bufferInfo, nullptr, &m_buffer) != VK_SUCCESS) 
+    try
     {
-        throw std::runtime_error("Failed to create buffer!");
+        m_allocation = m_allocator->AllocateForBuffer(m_buffer, properties);
+    }
+    catch (...)
+    {
+        vkDestroyBuffer(m_device, m_buffer, nullptr);
+        throw;
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device, m_buffer, &memRequirements);
+    m_registry->Track(VK_OBJECT_TYPE_BUFFER, m_buffer, size, site);
+
+    VkMemoryPropertyFlags typeFlags = m_allocator->GetMemoryProperties().memoryTypes[m_allocation.memoryType].propertyFlags;
+    m_coherent = (typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+Buffer::Buffer(Device* device,
+    const void* hostPointer,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    const std::vector<uint32_t>& queueFamilies,
+    std::source_location site)
+    : m_device(device->Get()), m_allocator(device->GetAllocator()), m_registry(device->GetRegistry()), m_size(size),
+    m_atomSize(std::max<VkDeviceSize>(device->GetProperties().limits.nonCoherentAtomSize, 1))
+{
+    // Buffers bound to imported memory have to be created for that handle type
+    VkExternalMemoryBufferCreateInfo externalInfo{};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+    CreateBuffer(size, usage, queueFamilies, &externalInfo);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+    try
+    {
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(m_device, m_buffer, &requirements);
+
+        uint32_t memoryTypes = device->GetHostPointerMemoryTypes(hostPointer) & requirements.memoryTypeBits;
+        if (memoryTypes == 0 || requirements.size > size)
+            throw std::runtime_error("Host memory cannot back the buffer!");
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &m_memory) != VK_SUCCESS) 
+        m_allocation = m_allocator->ImportHostMemory(m_buffer, hostPointer, size, memoryTypes);
+    }
+    catch (...)
     {
-        throw std::runtime_error("Failed to allocate buffer memory!");
+        vkDestroyBuffer(m_device, m_buffer, nullptr);
+        throw;
     }
 
-    vkBindBufferMemory(device, m_buffer, m_memory, 0);
+    m_registry->Track(VK_OBJECT_TYPE_BUFFER, m_buffer, size, site);
+
+    VkMemoryPropertyFlags typeFlags = m_allocator->GetMemoryProperties().memoryTypes[m_allocation.memoryType].propertyFlags;
+    m_coherent = (typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
 }
 
 Buffer::~Buffer() 
 {
     if (m_buffer != VK_NULL_HANDLE) 
     {
+        m_registry->Untrack(VK_OBJECT_TYPE_BUFFER, m_buffer);
         vkDestroyBuffer(m_device, m_buffer, nullptr);
     }
 
-    if (m_memory != VK_NULL_HANDLE) 
+    if (m_allocator)
     {
-        vkFreeMemory(m_device, m_memory, nullptr);
+        m_allocator->Free(m_allocation);
     }
 }
 
 void* Buffer::Map() const 
 {
-    void* data;
-    vkMapMemory(m_device, m_memory, 0, m_size, 0, &data);
-    return data;
+    if (!m_allocation.mapped)
+        throw std::runtime_error("Buffer memory is not host visible!");
+
+    return m_allocation.mapped;
 }
 
-void Buffer::Unmap() 
+void Buffer::CopyData(const void* data, VkDeviceSize size) 
 {
-    vkUnmapMemory(m_device, m_memory);
+    CopyData(0, std::span<const std::byte>(static_cast<const std::byte*>(data), static_cast<size_t>(size)));
 }
 
-void Buffer::CopyData(const void* data, VkDeviceSize size) 
+void Buffer::CopyData(VkDeviceSize offset, std::span<const std::byte> data)
 {
-    void* dst = Map();
-    memcpy(dst, data, static_cast<size_t>(size));
-    Unmap();
+    if (offset + data.size() > m_size)
+        throw std::runtime_error("Buffer write out of range!");
+
+    memcpy(static_cast<std::byte*>(Map()) + offset, data.data(), data.size());
+    Flush(offset, data.size());
 }
 
-uint32_t Buffer::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const 
+void Buffer::Flush(VkDeviceSize offset, VkDeviceSize size) const
 {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProperties);
+    if (m_coherent || !m_allocation.mapped)
+        return;
+
+    VkMappedMemoryRange range = GetMappedRange(offset, size);
+    if (vkFlushMappedMemoryRanges(m_device, 1, &range) != VK_SUCCESS)
+        throw std::runtime_error("Failed to flush buffer memory!");
+}
+
+void Buffer::Invalidate(VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (m_coherent || !m_allocation.mapped)
+        return;
+
+    VkMappedMemoryRange range = GetMappedRange(offset, size);
+    if (vkInvalidateMappedMemoryRanges(m_device, 1, &range) != VK_SUCCESS)
+        throw std::runtime_error("Failed to invalidate buffer memory!");
+}
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) 
+std::shared_ptr<Buffer> Buffer::CreateMoveTarget(std::source_location site) const
+{
+    auto target = std::make_shared<Buffer>();
+    target->m_device = m_device;
+    target->m_allocator = m_allocator;
+    target->m_registry = m_registry;
+    target->m_size = m_size;
+    target->m_atomSize = m_atomSize;
+    target->m_coherent = m_coherent;
+
+    target->CreateBuffer(m_size, m_usage, m_queueFamilies, nullptr);
+
+    try
+    {
+        target->m_allocation = m_allocator->AllocateMoveTarget(target->m_buffer, m_allocation);
+    }
+    catch (...)
+    {
+        vkDestroyBuffer(m_device, target->m_buffer, nullptr);
+        target->m_buffer = VK_NULL_HANDLE;
+        throw;
+    }
+
+    if (target->m_allocation.memory == VK_NULL_HANDLE)
     {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-        {
-            return i;
-        }
+        vkDestroyBuffer(m_device, target->m_buffer, nullptr);
+        target->m_buffer = VK_NULL_HANDLE;
+        return nullptr;
     }
 
-    throw std::runtime_error("Failed to find suitable memory type!");
-}
\ No newline at end of file
+    m_registry->Track(VK_OBJECT_TYPE_BUFFER, target->m_buffer, m_size, site);
+    return target;
+}
+
+void Buffer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies, const void* next)
+{
+    m_usage = usage;
+    m_queueFamilies = queueFamilies;
+
+    std::set<uint32_t> uniqueFamilies(queueFamilies.begin(), queueFamilies.end());
+    std::vector<uint32_t> sharedFamilies(uniqueFamilies.begin(), uniqueFamilies.end());
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.pNext = next;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = sharedFamilies.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    if (sharedFamilies.size() > 1)
+    {
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedFamilies.size());
+        bufferInfo.pQueueFamilyIndices = sharedFamilies.data();
+    }
+
+    if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_buffer) != VK_SUCCESS) 
+    {
+        throw std::runtime_error("Failed to create buffer!");
+    }
+}
+
+VkMappedMemoryRange Buffer::GetMappedRange(VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (size == VK_WHOLE_SIZE)
+        size = m_size - offset;
+
+    // Atom sizes are powers of two no larger than the smallest sub-allocation, so the widened range stays
+    // inside the allocation's reserved range
+    VkDeviceSize begin = (m_allocation.offset + offset) & ~(m_atomSize - 1);
+    VkDeviceSize end = (m_allocation.offset + offset + size + m_atomSize - 1) & ~(m_atomSize - 1);
+
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = m_allocation.memory;
+    range.offset = begin;
+    // A dedicated allocation ends with the buffer, its last atom may be partial
+    range.size = m_allocation.block < 0 && end > m_allocation.size ? VK_WHOLE_SIZE : end - begin;
+    return range;
+}
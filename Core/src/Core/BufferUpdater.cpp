@@ -0,0 +1,270 @@
+#include "BufferUpdater.h"
+
+// STD
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+    // Keeps staged ranges aligned for any element type written through them
+    constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+    constexpr VkDeviceSize MIN_STAGING_SIZE = 64 * 1024;
+    // Share of the host-visible heap's free budget the staging buffers of all slots may take together
+    constexpr VkDeviceSize STAGING_BUDGET_DIVISOR = 8;
+
+    VkDeviceSize AlignStaging(VkDeviceSize size)
+    {
+        return (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    }
+}
+
+BufferUpdater::BufferUpdater(std::shared_ptr<Device> device, uint32_t slotCount)
+	: m_device(device), m_staging(slotCount)
+{
+    MemoryHeapBudget heap = m_device->GetBudget(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VkDeviceSize available = heap.budget > heap.usage ? heap.budget - heap.usage : 0;
+    m_maxStagingSize = std::max(available / STAGING_BUDGET_DIVISOR / std::max(slotCount, 1u), MIN_STAGING_SIZE);
+}
+
+void BufferUpdater::Write(const std::shared_ptr<Buffer>& buffer, VkDeviceSize offset, std::span<const std::byte> data)
+{
+    if (data.empty())
+        return;
+
+    if (offset + data.size() > buffer->GetSize())
+        throw std::runtime_error("Buffer update out of range!");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    PendingBuffer& pending = m_pending[buffer.get()];
+    pending.buffer = buffer;
+    Merge(pending, offset, data);
+}
+
+void BufferUpdater::Merge(PendingBuffer& pending, VkDeviceSize offset, std::span<const std::byte> data)
+{
+    auto& ranges = pending.ranges;
+
+    VkDeviceSize begin = offset;
+    VkDeviceSize end = offset + data.size();
+
+    // The range starting at or before the write may reach into it, later ones touch it while they start no further than its end
+    auto first = ranges.upper_bound(begin);
+    if (first != ranges.begin() && std::prev(first)->first + std::prev(first)->second.size >= begin)
+        --first;
+
+    VkDeviceSize mergedBegin = begin;
+    VkDeviceSize mergedEnd = end;
+    auto last = first;
+    auto largest = ranges.end();
+    for (; last != ranges.end() && last->first <= end; ++last)
+    {
+        mergedBegin = std::min(mergedBegin, last->first);
+        mergedEnd = std::max<VkDeviceSize>(mergedEnd, last->first + last->second.size);
+        if (largest == ranges.end() || last->second.size > largest->second.size)
+            largest = last;
+    }
+
+    if (largest == ranges.end())
+    {
+        PendingRange range;
+        range.storage.assign(data.begin(), data.end());
+        range.size = data.size();
+        ranges.emplace(begin, std::move(range));
+        return;
+    }
+
+    // The largest range absorbs the others, so each byte is copied a logarithmic number of times at most.
+    // Older data first, then the write on top of it.
+    PendingRange& merged = largest->second;
+    merged.Grow(static_cast<size_t>(largest->first - mergedBegin), static_cast<size_t>(mergedEnd - (largest->first + merged.size)));
+    for (auto range = first; range != last; ++range)
+    {
+        if (range != largest)
+            memcpy(merged.GetData() + (range->first - mergedBegin), range->second.GetData(), range->second.size);
+    }
+    memcpy(merged.GetData() + (begin - mergedBegin), data.data(), data.size());
+
+    for (auto range = first; range != last;)
+        range = range == largest ? std::next(range) : ranges.erase(range);
+
+    if (largest->first != mergedBegin)
+    {
+        auto node = ranges.extract(largest);
+        node.key() = mergedBegin;
+        ranges.insert(std::move(node));
+    }
+}
+
+void BufferUpdater::PendingRange::Grow(size_t front, size_t back)
+{
+    if (begin >= front && storage.size() - begin - size >= back)
+    {
+        begin -= front;
+        size += front + back;
+        return;
+    }
+
+    // Reserving as much again as the grown range, half on each side, keeps repeated growth amortized linear
+    size_t grown = size + front + back;
+    std::vector<std::byte> grownStorage(grown * 2);
+    size_t grownBegin = grown / 2;
+    memcpy(grownStorage.data() + grownBegin + front, GetData(), size);
+
+    storage.swap(grownStorage);
+    begin = grownBegin;
+    size = grown;
+}
+
+bool BufferUpdater::HasPending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_pending.empty();
+}
+
+void BufferUpdater::Retarget(const std::shared_ptr<Buffer>& from, const std::shared_ptr<Buffer>& to)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto pending = m_pending.find(from.get());
+    if (pending == m_pending.end())
+        return;
+
+    PendingBuffer moved = std::move(pending->second);
+    moved.buffer = to;
+    m_pending.erase(pending);
+    m_pending[to.get()] = std::move(moved);
+}
+
+VkDeviceSize BufferUpdater::Record(VkCommandBuffer cmd, uint32_t slot, VkPipelineStageFlags readStages, VkAccessFlags readAccess)
+{
+    // Writes made while recording go to the next frame
+    std::map<Buffer*, PendingBuffer> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending.swap(m_pending);
+    }
+
+    if (pending.empty())
+        return 0;
+
+    // Ranges past the staging limit are moved out and kept for the next frame
+    VkDeviceSize stagingSize = 0;
+    std::map<Buffer*, PendingBuffer> deferred;
+    for (auto& [key, buffer] : pending)
+    {
+        for (auto range = buffer.ranges.begin(); range != buffer.ranges.end();)
+        {
+            VkDeviceSize size = AlignStaging(range->second.size);
+            if (stagingSize > 0 && stagingSize + size > m_maxStagingSize)
+            {
+                PendingBuffer& kept = deferred[key];
+                kept.buffer = buffer.buffer;
+                kept.ranges.insert(buffer.ranges.extract(range++));
+                continue;
+            }
+
+            stagingSize += size;
+            ++range;
+        }
+    }
+    std::erase_if(pending, [](const auto& buffer) { return buffer.second.ranges.empty(); });
+
+    if (!deferred.empty())
+    {
+        // Writes made since the swap are newer than the deferred ones, so they are merged on top
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& [key, buffer] : deferred)
+        {
+            auto newer = m_pending.find(key);
+            if (newer == m_pending.end())
+            {
+                m_pending.emplace(key, std::move(buffer));
+                continue;
+            }
+
+            PendingBuffer writes = std::move(newer->second);
+            newer->second = std::move(buffer);
+            for (const auto& [offset, range] : writes.ranges)
+                Merge(newer->second, offset, { range.GetData(), range.size });
+        }
+    }
+
+    // The slot's previous frame has completed, so its staging buffer can be rewritten or replaced
+    std::shared_ptr<Buffer>& staging = m_staging[slot];
+    if (!staging || staging->GetSize() < stagingSize)
+    {
+        VkDeviceSize capacity = staging ? staging->GetSize() : MIN_STAGING_SIZE;
+        while (capacity < stagingSize)
+            capacity *= 2;
+        capacity = std::max(std::min(capacity, m_maxStagingSize), stagingSize);
+
+        staging = std::make_shared<Buffer>(
+            m_device.get(),
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            std::vector<uint32_t>{},
+            std::source_location::current()
+        );
+    }
+    std::byte* stagingData = staging->GetMapped().data();
+
+    // Earlier frames may still read the ranges being overwritten, a write-after-read only needs execution order
+    vkCmdPipelineBarrier(cmd,
+        readStages,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        0, nullptr);
+
+    VkDeviceSize stagingOffset = 0;
+    VkDeviceSize copiedBytes = 0;
+    std::vector<VkBufferCopy> regions;
+    std::vector<VkBufferMemoryBarrier> barriers;
+    for (const auto& [key, buffer] : pending)
+    {
+        regions.clear();
+        for (const auto& [offset, range] : buffer.ranges)
+        {
+            memcpy(stagingData + stagingOffset, range.GetData(), range.size);
+
+            VkBufferCopy region{};
+            region.srcOffset = stagingOffset;
+            region.dstOffset = offset;
+            region.size = range.size;
+            regions.push_back(region);
+
+            stagingOffset += AlignStaging(range.size);
+            copiedBytes += range.size;
+        }
+
+        vkCmdCopyBuffer(cmd, staging->Get(), buffer.buffer->Get(), static_cast<uint32_t>(regions.size()), regions.data());
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        // Later copies may read or overwrite the buffer too, such as memory compaction moving it
+        barrier.dstAccessMask = readAccess | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer.buffer->Get();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barriers.push_back(barrier);
+    }
+    staging->Flush(0, stagingOffset);
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        readStages | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data(),
+        0, nullptr);
+
+    return copiedBytes;
+}
@@ -0,0 +1,239 @@
+#include "ClusterSorter.h"
+
+// PCR
+#include "ComputePipeline.h"
+#include "PushConstants.h"
+#include "Shaders.h"
+#include "Utils.h"
+
+// STD
+#include <algorithm>
+#include <array>
+
+ClusterSorter::ClusterSorter(std::shared_ptr<Device> device, std::shared_ptr<Buffer> clusterDepthBuffer, uint32_t particleCount, uint32_t clusterSize)
+	: m_device(device), m_clusterDepthBuffer(clusterDepthBuffer), m_particleCount(particleCount), m_clusterSize(clusterSize)
+{
+    m_clusterCount = (particleCount + clusterSize - 1) / clusterSize;
+
+    m_bucketBuffer = std::make_shared<Buffer>(
+        m_device.get(),
+        sizeof(uint32_t) * BUCKET_COUNT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        std::vector<uint32_t>{},
+        std::source_location::current()
+    );
+
+    m_drawCommandBuffer = std::make_shared<Buffer>(
+        m_device.get(),
+        sizeof(VkDrawIndirectCommand) * m_clusterCount,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        std::vector<uint32_t>{},
+        std::source_location::current()
+    );
+
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_device->Get(), &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cluster sort descriptor set layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size());
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(m_device->Get(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cluster sort descriptor pool!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(m_device->Get(), &allocInfo, &m_descriptorSet) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate cluster sort descriptor set!");
+
+    std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+    bufferInfos[0].buffer = m_clusterDepthBuffer->Get();
+    bufferInfos[1].buffer = m_bucketBuffer->Get();
+    bufferInfos[2].buffer = m_drawCommandBuffer->Get();
+
+    std::array<VkWriteDescriptorSet, 3> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+        bufferInfos[i].offset = 0;
+        bufferInfos[i].range = VK_WHOLE_SIZE;
+
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].dstArrayElement = 0;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+
+    vkUpdateDescriptorSets(m_device->Get(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(ClusterOrderPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+
+    if (vkCreatePipelineLayout(m_device->Get(), &pipelineLayoutInfo, nullptr, &m_layout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cluster sort pipeline layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
+
+    VkShaderModule shader = Shaders::CreateModule(m_device->Get(), Shaders::PointCloudOrder);
+
+    VkPipelineShaderStageCreateInfo stage{};
+    stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage.module = shader;
+    stage.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = stage;
+    pipelineInfo.layout = m_layout;
+
+    if (vkCreateComputePipelines(m_device->Get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cluster sort pipeline!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
+
+    vkDestroyShaderModule(m_device->Get(), shader, nullptr);
+}
+
+ClusterSorter::~ClusterSorter()
+{
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
+    vkDestroyPipeline(m_device->Get(), m_pipeline, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
+    vkDestroyPipelineLayout(m_device->Get(), m_layout, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+    vkDestroyDescriptorPool(m_device->Get(), m_descriptorPool, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
+    vkDestroyDescriptorSetLayout(m_device->Get(), m_descriptorSetLayout, nullptr);
+}
+
+bool ClusterSorter::IsSupported(Device* device)
+{
+    return device->GetEnabledFeatures().multiDrawIndirect == VK_TRUE;
+}
+
+void ClusterSorter::Record(VkCommandBuffer cmd, float depthMin, float depthMax)
+{
+    // Previous frame's scatter and indirect reads must finish before the buckets and commands are rewritten
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+
+    vkCmdFillBuffer(cmd, m_bucketBuffer->Get(), 0, VK_WHOLE_SIZE, 0);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &m_descriptorSet, 0, nullptr);
+
+    uint32_t clusterGroups = (m_clusterCount + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE;
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    Dispatch(cmd, 0, clusterGroups, depthMin, depthMax);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    Dispatch(cmd, 1, 1, depthMin, depthMax);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    Dispatch(cmd, 2, clusterGroups, depthMin, depthMax);
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+}
+
+void ClusterSorter::Draw(VkCommandBuffer cmd)
+{
+    Draw(cmd, 0, m_clusterCount);
+}
+
+void ClusterSorter::Draw(VkCommandBuffer cmd, uint32_t firstCluster, uint32_t clusterCount)
+{
+    uint32_t maxDrawCount = std::max(m_device->GetProperties().limits.maxDrawIndirectCount, 1u);
+    uint32_t endCluster = std::min(firstCluster + clusterCount, m_clusterCount);
+
+    for (uint32_t first = firstCluster; first < endCluster; first += maxDrawCount)
+    {
+        uint32_t drawCount = std::min(maxDrawCount, endCluster - first);
+        vkCmdDrawIndirect(cmd, m_drawCommandBuffer->Get(), sizeof(VkDrawIndirectCommand) * first, drawCount, sizeof(VkDrawIndirectCommand));
+    }
+}
+
+void ClusterSorter::Dispatch(VkCommandBuffer cmd, uint32_t pass, uint32_t groupCount, float depthMin, float depthMax)
+{
+    ClusterOrderPushConstants pc{};
+    pc.pass = pass;
+    pc.numClusters = m_clusterCount;
+    pc.numParticles = m_particleCount;
+    pc.clusterSize = m_clusterSize;
+    pc.depthMin = depthMin;
+    pc.depthMax = depthMax;
+    vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ClusterOrderPushConstants), &pc);
+
+    VkExtent3D grid = ComputePipeline::GetDispatchGrid(m_device.get(), groupCount);
+    vkCmdDispatch(cmd, grid.width, grid.height, grid.depth);
+}
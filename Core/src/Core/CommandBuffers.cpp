@@ -3,18 +3,63 @@
 // STD
 #include <stdexcept>
 
-CommandBuffers::CommandBuffers(VkDevice device, VkCommandPool commandPool, VkRenderPass renderPass, const std::vector<VkFramebuffer>& framebuffers, VkExtent2D extent)
-	: m_device(device), m_framebuffers(framebuffers), m_extent(extent)
+CommandBuffers::CommandBuffers(Device* device, uint32_t queueFamilyIndex, uint32_t count, bool reusable)
+	: m_device(device->Get()), m_registry(device->GetRegistry()), m_reusable(reusable)
 {
-    m_commandBuffers.resize(framebuffers.size());
+    m_commandPools.resize(count, VK_NULL_HANDLE);
+    m_commandBuffers.resize(count, VK_NULL_HANDLE);
 
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(m_commandBuffers.size());
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Pools are reset as a whole, individual buffers never are
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = m_reusable ? 0 : VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = queueFamilyIndex;
 
-    if (vkAllocateCommandBuffers(m_device, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate command buffers!");
+        if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPools[i]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create command pool!");
+        }
+        m_registry->Track(VK_OBJECT_TYPE_COMMAND_POOL, m_commandPools[i]);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = m_commandPools[i];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(m_device, &allocInfo, &m_commandBuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers!");
+        }
+    }
+}
+
+CommandBuffers::~CommandBuffers()
+{
+    // Destroying a pool frees the command buffers allocated from it
+    for (auto pool : m_commandPools)
+    {
+        if (pool != VK_NULL_HANDLE)
+        {
+            m_registry->Untrack(VK_OBJECT_TYPE_COMMAND_POOL, pool);
+            vkDestroyCommandPool(m_device, pool, nullptr);
+        }
+    }
+}
+
+VkCommandBuffer CommandBuffers::Begin(uint32_t frame)
+{
+    if (vkResetCommandPool(m_device, m_commandPools[frame], 0) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to reset command pool!");
     }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = m_reusable ? 0 : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(m_commandBuffers[frame], &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin command buffer!");
+    }
+
+    return m_commandBuffers[frame];
 }
@@ -4,17 +4,20 @@
 #include "DescriptorPool.h"
 #include "Device.h"
 #include "PushConstants.h"
-#include "Utils.h"
+#include "Shaders.h"
 
 // STD
+#include <algorithm>
 #include <stdexcept>
 
 // VULKAN
 #include <vulkan/vulkan.h>
 
-ComputePipeline::ComputePipeline(std::shared_ptr<DescriptorPool> descriptorPool, std::shared_ptr<Device> device)
+ComputePipeline::ComputePipeline(std::shared_ptr<DescriptorPool> descriptorPool, std::shared_ptr<Device> device, VkDescriptorSetLayout frameSetLayout)
 	: m_device(device)
 {
+    VkDescriptorSetLayout setLayouts[] = { *descriptorPool->GetDescriptorSetLayout(), frameSetLayout };
+
     VkPushConstantRange compPush{};
     compPush.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     compPush.offset = 0;
@@ -22,16 +25,16 @@ ComputePipeline::ComputePipeline(std::shared_ptr<DescriptorPool> descriptorPool,
 
     VkPipelineLayoutCreateInfo compLayoutInfo{};
     compLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    compLayoutInfo.setLayoutCount = 1;
-    compLayoutInfo.pSetLayouts = descriptorPool->GetDescriptorSetLayout();
+    compLayoutInfo.setLayoutCount = 2;
+    compLayoutInfo.pSetLayouts = setLayouts;
     compLayoutInfo.pushConstantRangeCount = 1;
     compLayoutInfo.pPushConstantRanges = &compPush;
 
     if (vkCreatePipelineLayout(device->Get(), &compLayoutInfo, nullptr, &m_layout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create compute pipeline layout!");
+    device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
 
-    auto compCode = Utils::ReadFile("shaders/pointcloud.comp.spv");
-    VkShaderModule compShader = Utils::CreateShaderModule(device->Get(), compCode);
+    VkShaderModule compShader = Shaders::CreateModule(device->Get(), Shaders::PointCloudComp);
 
     VkPipelineShaderStageCreateInfo compStage{};
     compStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -46,12 +49,32 @@ ComputePipeline::ComputePipeline(std::shared_ptr<DescriptorPool> descriptorPool,
 
     if (vkCreateComputePipelines(device->Get(), VK_NULL_HANDLE, 1, &computePipeInfo, nullptr, &m_pipeline) != VK_SUCCESS)
         throw std::runtime_error("Failed to create compute pipeline!");
+    device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
 
     vkDestroyShaderModule(device->Get(), compShader, nullptr);
 }
 
 ComputePipeline::~ComputePipeline()
 {
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
     vkDestroyPipeline(m_device->Get(), m_pipeline, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
     vkDestroyPipelineLayout(m_device->Get(), m_layout, nullptr);
-}
\ No newline at end of file
+}
+
+VkExtent3D ComputePipeline::GetDispatchGrid(const Device* device, uint32_t groupCount)
+{
+    const uint32_t* maxCount = device->GetProperties().limits.maxComputeWorkGroupCount;
+
+    VkExtent3D grid{};
+    grid.width = std::clamp(groupCount, 1u, maxCount[0]);
+    uint32_t rows = (groupCount + grid.width - 1) / grid.width;
+    grid.height = std::clamp(rows, 1u, maxCount[1]);
+    grid.depth = (rows + grid.height - 1) / grid.height;
+
+    if (grid.depth > maxCount[2])
+        throw std::runtime_error("Dispatch exceeds maxComputeWorkGroupCount!");
+
+    grid.depth = std::max(grid.depth, 1u);
+    return grid;
+}
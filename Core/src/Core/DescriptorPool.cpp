@@ -1,27 +1,11 @@
 #include "DescriptorPool.h"
 
-// PCR
-#include "CommandBuffers.h"
-
 // STD
 #include <array>
 
-DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<RenderPass> renderPass, std::shared_ptr<Swapchain> swapchain, std::shared_ptr<Buffer> triangleBuffer, std::shared_ptr<Buffer> pointBuffer)
-	: m_device(device), m_renderPass(renderPass), m_swapchain(swapchain)
+DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<Buffer> triangleBuffer, std::shared_ptr<Buffer> pointBuffer, std::shared_ptr<Buffer> clusterDepthBuffer)
+	: m_device(device)
 {
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    poolInfo.queueFamilyIndex = m_device->GetGraphicsFamilyIndex();
-    VkCommandPool commandPool = VK_NULL_HANDLE;
-    if (vkCreateCommandPool(m_device->Get(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create command pool!");
-
-    m_commandBuffers = std::make_shared<CommandBuffers>(m_device->Get(), commandPool,
-        m_renderPass->Get(),
-        m_renderPass->GetFramebuffers(),
-        m_swapchain->GetExtent());
-
     VkDescriptorSetLayoutBinding triBinding{};
     triBinding.binding = 0;
     triBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -34,7 +18,13 @@ DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<R
     pointBinding.descriptorCount = 1;
     pointBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
-    std::array<VkDescriptorSetLayoutBinding, 2> descBindings = { triBinding, pointBinding };
+    VkDescriptorSetLayoutBinding clusterBinding{};
+    clusterBinding.binding = 2;
+    clusterBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    clusterBinding.descriptorCount = 1;
+    clusterBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding, 3> descBindings = { triBinding, pointBinding, clusterBinding };
 
     VkDescriptorSetLayoutCreateInfo descLayoutInfo{};
     descLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -43,10 +33,11 @@ DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<R
 
     if (vkCreateDescriptorSetLayout(m_device->Get(), &descLayoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create descriptor set layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
 
     VkDescriptorPoolSize poolSizes[1];
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSizes[0].descriptorCount = 2;
+    poolSizes[0].descriptorCount = 3;
 
     VkDescriptorPoolCreateInfo poolCreate{};
     poolCreate.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -54,13 +45,13 @@ DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<R
     poolCreate.pPoolSizes = poolSizes;
     poolCreate.maxSets = 1;
 
-    VkDescriptorPool descPool;
-    if (vkCreateDescriptorPool(m_device->Get(), &poolCreate, nullptr, &descPool) != VK_SUCCESS)
+    if (vkCreateDescriptorPool(m_device->Get(), &poolCreate, nullptr, &m_descriptorPool) != VK_SUCCESS)
         throw std::runtime_error("Failed to create descriptor pool!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
 
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descPool;
+    allocInfo.descriptorPool = m_descriptorPool;
     allocInfo.descriptorSetCount = 1;
     allocInfo.pSetLayouts = GetDescriptorSetLayout();
 
@@ -77,6 +68,11 @@ DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<R
     pointBufInfo.offset = 0;
     pointBufInfo.range = VK_WHOLE_SIZE;
 
+    VkDescriptorBufferInfo clusterBufInfo{};
+    clusterBufInfo.buffer = clusterDepthBuffer->Get();
+    clusterBufInfo.offset = 0;
+    clusterBufInfo.range = VK_WHOLE_SIZE;
+
     VkWriteDescriptorSet writeTri{};
     writeTri.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     writeTri.dstSet = m_computeDescriptorSet;
@@ -95,11 +91,24 @@ DescriptorPool::DescriptorPool(std::shared_ptr<Device> device, std::shared_ptr<R
     writePoint.descriptorCount = 1;
     writePoint.pBufferInfo = &pointBufInfo;
 
-    std::array<VkWriteDescriptorSet, 2> writeSets = { writeTri, writePoint };
+    VkWriteDescriptorSet writeCluster{};
+    writeCluster.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeCluster.dstSet = m_computeDescriptorSet;
+    writeCluster.dstBinding = 2;
+    writeCluster.dstArrayElement = 0;
+    writeCluster.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeCluster.descriptorCount = 1;
+    writeCluster.pBufferInfo = &clusterBufInfo;
+
+    std::array<VkWriteDescriptorSet, 3> writeSets = { writeTri, writePoint, writeCluster };
     vkUpdateDescriptorSets(m_device->Get(), static_cast<uint32_t>(writeSets.size()), writeSets.data(), 0, nullptr);
 }
 
 DescriptorPool::~DescriptorPool()
 {
+	// Destroying the pool frees the compute descriptor set
+	m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+	vkDestroyDescriptorPool(m_device->Get(), m_descriptorPool, nullptr);
+	m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
 	vkDestroyDescriptorSetLayout(m_device->Get(), m_descriptorSetLayout, nullptr);
 }
@@ -1,7 +1,11 @@
 #include "Device.h"
 
+// STD
+#include <cassert>
+#include <iostream>
+
 Device::Device(VkInstance instance, VkSurfaceKHR surface)
-    : m_instance(instance), m_surface(surface)
+    : m_instance(instance), m_surface(surface), m_registry(std::make_shared<ResourceRegistry>())
 {
 	PickPhysicalDevice();
 	CreateLogicalDevice();
@@ -9,6 +13,14 @@ Device::Device(VkInstance instance, VkSurfaceKHR surface)
 
 Device::~Device()
 {
+	// Buffers hold the allocator, one outliving the device would free its memory after vkDestroyDevice
+	assert(m_allocator.use_count() <= 1 && "Buffers outlive the device");
+	m_allocator.reset();
+
+	// Every owner has been destroyed by now, anything still registered was never released
+	if (uint32_t leaked = m_registry->ReportLeaks())
+		std::cerr << "[Device] " << leaked << " Vulkan objects leaked" << std::endl;
+
 	if (m_device != VK_NULL_HANDLE) {
 		vkDestroyDevice(m_device, nullptr);
 	}
@@ -31,6 +43,8 @@ void Device::PickPhysicalDevice()
             m_physicalDevice = device;
             m_graphicsFamily = indices.graphicsFamily;
             m_presentFamily = indices.presentFamily;
+            m_computeFamily = indices.computeFamily;
+            m_transferFamily = indices.transferFamily;
             break;
         }
     }
@@ -39,8 +53,28 @@ void Device::PickPhysicalDevice()
         throw std::runtime_error("Failed to find a suitable GPU!");
     }
 
-    VkPhysicalDeviceProperties props;
-    vkGetPhysicalDeviceProperties(m_physicalDevice, &props);
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &m_properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, families.data());
+    m_timestampValidBits = families[m_graphicsFamily].timestampValidBits;
+
+    VkPhysicalDeviceMultiviewProperties multiviewProps{};
+    multiviewProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_PROPERTIES;
+
+    VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostMemoryProps{};
+    hostMemoryProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+    if (IsExtensionSupported(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME))
+        multiviewProps.pNext = &hostMemoryProps;
+
+    VkPhysicalDeviceProperties2 props2{};
+    props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props2.pNext = &multiviewProps;
+    vkGetPhysicalDeviceProperties2(m_physicalDevice, &props2);
+    m_maxMultiviewViewCount = multiviewProps.maxMultiviewViewCount;
+    m_hostPointerAlignment = hostMemoryProps.minImportedHostPointerAlignment;
 }
 
 Device::QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device)
@@ -68,13 +102,31 @@ Device::QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device)
         i++;
     }
 
+    // Families with compute but no graphics usually map to separate hardware queues that run alongside rendering
+    indices.computeFamily = indices.graphicsFamily;
+    for (uint32_t family = 0; family < families.size(); ++family) {
+        if ((families[family].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            indices.computeFamily = family;
+            break;
+        }
+    }
+
+    // Transfer-only families are backed by copy engines that stream data without occupying the graphics queue
+    indices.transferFamily = indices.graphicsFamily;
+    for (uint32_t family = 0; family < families.size(); ++family) {
+        if ((families[family].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(families[family].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            indices.transferFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
 void Device::CreateLogicalDevice()
 {
     std::vector<VkDeviceQueueCreateInfo> queueInfos;
-    std::set<uint32_t> uniqueFamilies = { m_graphicsFamily, m_presentFamily };
+    std::set<uint32_t> uniqueFamilies = { m_graphicsFamily, m_presentFamily, m_computeFamily, m_transferFamily };
 
     float queuePriority = 1.0f;
     for (uint32_t family : uniqueFamilies) {
@@ -86,23 +138,144 @@ void Device::CreateLogicalDevice()
         queueInfos.push_back(queueInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+    // Optional, used for front-to-back ordered cluster draws
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+
+    // Optional, used to render several cameras in one pass
+    VkPhysicalDeviceMultiviewFeatures multiviewFeatures{};
+    multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+
+    // Required, frames are scheduled on a timeline semaphore (core since Vulkan 1.2)
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    multiviewFeatures.pNext = &timelineFeatures;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures2{};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &multiviewFeatures;
+    vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures2);
+
+    if (!timelineFeatures.timelineSemaphore) {
+        throw std::runtime_error("Timeline semaphores are not supported by the GPU!");
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures enabledTimeline{};
+    enabledTimeline.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    enabledTimeline.timelineSemaphore = VK_TRUE;
+
+    VkPhysicalDeviceMultiviewFeatures enabledMultiview{};
+    enabledMultiview.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+    enabledMultiview.pNext = &enabledTimeline;
+    enabledMultiview.multiview = multiviewFeatures.multiview;
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &enabledMultiview;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
     createInfo.pQueueCreateInfos = queueInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    const char* deviceExtensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-    createInfo.enabledExtensionCount = 1;
-    createInfo.ppEnabledExtensionNames = deviceExtensions;
+    std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+    // Optional, reports how much memory the process can use per heap
+    m_memoryBudgetEnabled = IsExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (m_memoryBudgetEnabled)
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // Optional, lets buffers read application memory in place instead of a copy of it
+    m_hostMemoryImportEnabled = m_hostPointerAlignment > 0;
+    if (m_hostMemoryImportEnabled)
+        deviceExtensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
     if (vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create logical device!");
     }
 
+    m_enabledFeatures = deviceFeatures;
+    m_multiviewEnabled = enabledMultiview.multiview == VK_TRUE;
+
     vkGetDeviceQueue(m_device, m_graphicsFamily, 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, m_presentFamily, 0, &m_presentQueue);
-}
\ No newline at end of file
+    vkGetDeviceQueue(m_device, m_computeFamily, 0, &m_computeQueue);
+    vkGetDeviceQueue(m_device, m_transferFamily, 0, &m_transferQueue);
+
+    if (m_hostMemoryImportEnabled) {
+        m_getMemoryHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT)
+            vkGetDeviceProcAddr(m_device, "vkGetMemoryHostPointerPropertiesEXT");
+        m_hostMemoryImportEnabled = m_getMemoryHostPointerProperties != nullptr;
+    }
+
+    m_allocator = std::make_shared<MemoryAllocator>(m_device, m_physicalDevice, m_registry);
+}
+
+bool Device::IsExtensionSupported(const char* name) const
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions) {
+        if (std::string(extension.extensionName) == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<MemoryHeapBudget> Device::GetMemoryBudgets() const
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProps{};
+    budgetProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memoryProps2{};
+    memoryProps2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProps2.pNext = m_memoryBudgetEnabled ? &budgetProps : nullptr;
+    vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &memoryProps2);
+
+    const VkPhysicalDeviceMemoryProperties& memoryProps = memoryProps2.memoryProperties;
+    std::vector<MemoryHeapBudget> budgets(memoryProps.memoryHeapCount);
+    for (uint32_t heap = 0; heap < memoryProps.memoryHeapCount; ++heap) {
+        budgets[heap].size = memoryProps.memoryHeaps[heap].size;
+        budgets[heap].deviceLocal = (memoryProps.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
+        if (m_memoryBudgetEnabled) {
+            budgets[heap].budget = budgetProps.heapBudget[heap];
+            budgets[heap].usage = budgetProps.heapUsage[heap];
+        }
+        else {
+            budgets[heap].budget = memoryProps.memoryHeaps[heap].size;
+            budgets[heap].usage = m_allocator->GetHeapReservedBytes(heap);
+        }
+    }
+    return budgets;
+}
+
+MemoryHeapBudget Device::GetBudget(VkMemoryPropertyFlags properties) const
+{
+    uint32_t memoryType = m_allocator->FindMemoryType(~0u, properties);
+    uint32_t heap = m_allocator->GetMemoryProperties().memoryTypes[memoryType].heapIndex;
+    return GetMemoryBudgets()[heap];
+}
+
+uint32_t Device::GetHostPointerMemoryTypes(const void* hostPointer) const
+{
+    if (!m_hostMemoryImportEnabled)
+        return 0;
+
+    VkMemoryHostPointerPropertiesEXT pointerProps{};
+    pointerProps.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+    if (m_getMemoryHostPointerProperties(m_device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, hostPointer, &pointerProps) != VK_SUCCESS)
+        return 0;
+
+    return pointerProps.memoryTypeBits;
+}
@@ -0,0 +1,27 @@
+#include "FrameClock.h"
+
+FrameClock::FrameClock()
+	: m_lastTick(Clock::now())
+{
+}
+
+void FrameClock::Tick()
+{
+    Clock::time_point now = Clock::now();
+    m_realDeltaMs = std::chrono::duration<float, std::milli>(now - m_lastTick).count();
+    m_lastTick = now;
+
+    // The first frame has no predecessor, its delta only measures setup time
+    if (m_frameIndex == 0)
+        m_realDeltaMs = 0.0f;
+
+    if (m_paused)
+        m_deltaMs = 0.0f;
+    else if (m_fixedStepMs > 0.0f)
+        m_deltaMs = m_fixedStepMs;
+    else
+        m_deltaMs = m_realDeltaMs;
+
+    m_time += m_deltaMs / 1000.0;
+    m_frameIndex++;
+}
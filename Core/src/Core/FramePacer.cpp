@@ -0,0 +1,39 @@
+#include "FramePacer.h"
+
+// STD
+#include <thread>
+
+namespace
+{
+    // Sleep granularity is coarse on most platforms, the last stretch before a deadline is spent yielding instead
+    constexpr std::chrono::microseconds SPIN_MARGIN(1500);
+}
+
+void FramePacer::SetTargetFrameTimeMs(float targetFrameTimeMs)
+{
+    m_targetFrameTimeMs = targetFrameTimeMs > 0.0f ? targetFrameTimeMs : 0.0f;
+    m_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(m_targetFrameTimeMs));
+    m_deadline = Clock::time_point{};
+}
+
+float FramePacer::Wait()
+{
+    if (!IsEnabled())
+        return 0.0f;
+
+    Clock::time_point start = Clock::now();
+    if (m_deadline == Clock::time_point{} || start > m_deadline + m_interval)
+    {
+        m_deadline = start + m_interval;
+        return 0.0f;
+    }
+
+    if (m_deadline - start > SPIN_MARGIN)
+        std::this_thread::sleep_until(m_deadline - SPIN_MARGIN);
+    while (Clock::now() < m_deadline)
+        std::this_thread::yield();
+
+    // Deadlines advance by whole intervals so small oversleeps do not accumulate into drift
+    m_deadline += m_interval;
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
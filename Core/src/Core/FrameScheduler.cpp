@@ -0,0 +1,64 @@
+#include "FrameScheduler.h"
+
+// PCR
+#include "Utils.h"
+
+// STD
+#include <algorithm>
+
+FrameScheduler::FrameScheduler(std::shared_ptr<Device> device, uint32_t framesInFlight)
+	: m_device(device), m_framesInFlight(std::max(framesInFlight, 1u))
+{
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semInfo.pNext = &typeInfo;
+
+    if (vkCreateSemaphore(m_device->Get(), &semInfo, nullptr, &m_timeline) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to create frame timeline semaphore!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_SEMAPHORE, m_timeline);
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_SEMAPHORE, m_timeline);
+    vkDestroySemaphore(m_device->Get(), m_timeline, nullptr);
+}
+
+uint64_t FrameScheduler::BeginFrame()
+{
+    uint64_t frame = GetFrameNumber();
+
+    // The slot was last used framesInFlight frames ago
+    if (frame > m_framesInFlight)
+        WaitForFrame(frame - m_framesInFlight);
+
+    return frame;
+}
+
+uint64_t FrameScheduler::GetCompletedFrame() const
+{
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(m_device->Get(), m_timeline, &value) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to query frame timeline semaphore!");
+    return value;
+}
+
+void FrameScheduler::WaitForFrame(uint64_t frame) const
+{
+    if (frame == 0)
+        return;
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_timeline;
+    waitInfo.pValues = &frame;
+
+    if (vkWaitSemaphores(m_device->Get(), &waitInfo, UINT64_MAX) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to wait on frame timeline semaphore!");
+}
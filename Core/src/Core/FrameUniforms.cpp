@@ -0,0 +1,95 @@
+#include "FrameUniforms.h"
+
+// STD
+#include <span>
+#include <stdexcept>
+
+FrameUniforms::FrameUniforms(std::shared_ptr<Device> device, uint32_t slotCount)
+	: m_device(device)
+{
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        m_buffers.push_back(std::make_shared<Buffer>(
+            m_device.get(),
+            sizeof(FrameUniformData),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            std::vector<uint32_t>{},
+            std::source_location::current()
+        ));
+    }
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(m_device->Get(), &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create frame descriptor set layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSize.descriptorCount = slotCount;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = slotCount;
+
+    if (vkCreateDescriptorPool(m_device->Get(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create frame descriptor pool!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+
+    std::vector<VkDescriptorSetLayout> setLayouts(slotCount, m_descriptorSetLayout);
+    m_descriptorSets.resize(slotCount);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = slotCount;
+    allocInfo.pSetLayouts = setLayouts.data();
+
+    if (vkAllocateDescriptorSets(m_device->Get(), &allocInfo, m_descriptorSets.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate frame descriptor sets!");
+
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = m_buffers[i]->Get();
+        bufferInfo.offset = 0;
+        bufferInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_descriptorSets[i];
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(m_device->Get(), 1, &write, 0, nullptr);
+    }
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+    vkDestroyDescriptorPool(m_device->Get(), m_descriptorPool, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
+    vkDestroyDescriptorSetLayout(m_device->Get(), m_descriptorSetLayout, nullptr);
+}
+
+void FrameUniforms::Write(uint32_t slot, const FrameUniformData& data)
+{
+    // Written through the persistent mapping, submission makes host writes visible to the device
+    m_buffers[slot]->CopyData(0, std::as_bytes(std::span(&data, 1)));
+}
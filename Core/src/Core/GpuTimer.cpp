@@ -0,0 +1,55 @@
+#include "GpuTimer.h"
+
+// PCR
+#include "Utils.h"
+
+GpuTimer::GpuTimer(std::shared_ptr<Device> device, uint32_t frameCount)
+	: m_device(device), m_written(frameCount, false), m_timestampPeriod(device->GetProperties().limits.timestampPeriod)
+{
+    // Only the low timestampValidBits of each timestamp are meaningful, so deltas are taken modulo that width
+    uint32_t validBits = m_device->GetTimestampValidBits();
+    m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryInfo{};
+    queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = frameCount * 2;
+
+    if (vkCreateQueryPool(m_device->Get(), &queryInfo, nullptr, &m_queryPool) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to create timestamp query pool!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_QUERY_POOL, m_queryPool);
+}
+
+GpuTimer::~GpuTimer()
+{
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_QUERY_POOL, m_queryPool);
+    vkDestroyQueryPool(m_device->Get(), m_queryPool, nullptr);
+}
+
+void GpuTimer::Begin(VkCommandBuffer cmd, uint32_t frame)
+{
+    vkCmdResetQueryPool(cmd, m_queryPool, frame * 2, 2);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, frame * 2);
+}
+
+void GpuTimer::End(VkCommandBuffer cmd, uint32_t frame)
+{
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, frame * 2 + 1);
+    m_written[frame] = true;
+}
+
+bool GpuTimer::GetElapsedMs(uint32_t frame, float& elapsedMs) const
+{
+    if (!m_written[frame])
+        return false;
+
+    uint64_t timestamps[2] = {};
+    VkResult result = vkGetQueryPoolResults(m_device->Get(), m_queryPool, frame * 2, 2,
+        sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    if (result != VK_SUCCESS)
+        return false;
+
+    elapsedMs = static_cast<float>((timestamps[1] - timestamps[0]) & m_timestampMask) * m_timestampPeriod / 1000000.0f;
+    return true;
+}
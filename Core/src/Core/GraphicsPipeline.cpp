@@ -2,15 +2,17 @@
 
 // PCR
 #include "PushConstants.h"
+#include "Shaders.h"
 #include "Utils.h"
 
-GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::shared_ptr<Swapchain> swapchain, std::shared_ptr<Device> device)
+GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::shared_ptr<Device> device, VkDescriptorSetLayout frameSetLayout)
 	: m_device(device)
 {
-    auto vertCode = Utils::ReadFile("shaders/pointcloud.vert.spv");
-    auto fragCode = Utils::ReadFile("shaders/pointcloud.frag.spv");
-    VkShaderModule vertShader = Utils::CreateShaderModule(m_device->Get(), vertCode);
-    VkShaderModule fragShader = Utils::CreateShaderModule(m_device->Get(), fragCode);
+    bool multiview = renderPass->GetSettings().viewCount > 1;
+    VkShaderModule vertShader = Shaders::CreateModule(m_device->Get(),
+        multiview ? Shaders::PointCloudMultiviewVert : Shaders::PointCloudVert);
+    VkShaderModule fragShader = Shaders::CreateModule(m_device->Get(),
+        renderPass->GetSettings().splatting ? Shaders::PointCloudSplatFrag : Shaders::PointCloudFrag);
 
     VkPushConstantRange gfxPush{};
     gfxPush.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
@@ -19,13 +21,14 @@ GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::
 
     VkPipelineLayoutCreateInfo gfxPLInfo{};
     gfxPLInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    gfxPLInfo.setLayoutCount = 0;
-    gfxPLInfo.pSetLayouts = nullptr;
+    gfxPLInfo.setLayoutCount = 1;
+    gfxPLInfo.pSetLayouts = &frameSetLayout;
     gfxPLInfo.pushConstantRangeCount = 1;
     gfxPLInfo.pPushConstantRanges = &gfxPush;
 
     if (vkCreatePipelineLayout(m_device->Get(), &gfxPLInfo, nullptr, &m_layout) != VK_SUCCESS)
         Utils::ThrowFatalError("Failed to create graphics pipeline layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
 
     VkPipelineShaderStageCreateInfo vertStage{};
     vertStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -64,24 +67,17 @@ GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::
     inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)swapchain->GetExtent().width;
-    viewport.height = (float)swapchain->GetExtent().height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor{};
-    scissor.offset = { 0,0 };
-    scissor.extent = swapchain->GetExtent();
-
     VkPipelineViewportStateCreateInfo viewportState{};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
 
     VkPipelineRasterizationStateCreateInfo rasterizer{};
     rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -98,6 +94,15 @@ GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::
     multisample.sampleShadingEnable = VK_FALSE;
     multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
+    // Points are opaque and the fragment shader never writes depth, so occluded fragments are rejected before shading
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = renderPass->HasDepth() ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = renderPass->HasDepth() ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
     VkPipelineColorBlendAttachmentState colorBlendAttachment{};
     colorBlendAttachment.colorWriteMask =
         VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
@@ -119,13 +124,16 @@ GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::
     pipelineInfo.pViewportState = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = m_layout;
     pipelineInfo.renderPass = renderPass->Get();
     pipelineInfo.subpass = 0;
 
     if (vkCreateGraphicsPipelines(m_device->Get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS)
         Utils::ThrowFatalError("Failed to create graphics pipeline!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
 
     vkDestroyShaderModule(m_device->Get(), vertShader, nullptr);
     vkDestroyShaderModule(m_device->Get(), fragShader, nullptr);
@@ -133,6 +141,26 @@ GraphicsPipeline::GraphicsPipeline(std::shared_ptr<RenderPass> renderPass, std::
 
 GraphicsPipeline::~GraphicsPipeline()
 {
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
     vkDestroyPipeline(m_device->Get(), m_pipeline, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
     vkDestroyPipelineLayout(m_device->Get(), m_layout, nullptr);
+}
+
+void GraphicsPipeline::SetViewport(VkCommandBuffer cmd, VkExtent2D extent)
+{
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.offset = { 0,0 };
+    scissor.extent = extent;
+
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
 }
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "HoleFiller.h"
+
+// PCR
+#include "PushConstants.h"
+#include "Shaders.h"
+
+// STD
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t MODE_GATHER = 0;
+    constexpr uint32_t MODE_PULL = 1;
+    constexpr uint32_t MODE_PUSH = 2;
+
+    constexpr uint32_t GROUP_SIZE = 8;
+}
+
+HoleFiller::HoleFiller(std::shared_ptr<Device> device, std::shared_ptr<RenderPass> renderPass, uint32_t levels)
+	: m_device(device), m_renderPass(renderPass)
+{
+    Image* target = m_renderPass->GetColorTarget();
+    if (!target || !m_renderPass->GetSettings().splatting)
+        throw std::runtime_error("Hole filling requires a splatting render pass!");
+
+    VkExtent2D extent = target->GetExtent();
+    if (!CanFill(extent))
+        throw std::runtime_error("Hole filling requires a target of at least two pixels!");
+
+    uint32_t maxLevels = 1;
+    while ((std::max(extent.width, extent.height) >> maxLevels) > 0)
+        maxLevels++;
+
+    m_levelCount = std::clamp(levels + 1, 2u, maxLevels);
+
+    m_colorPyramid = std::make_unique<Image>(m_device->Get(), *m_device->GetAllocator(), m_device->GetRegistry(), extent,
+        VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT, VK_IMAGE_ASPECT_COLOR_BIT, m_levelCount, 1, std::source_location::current());
+    m_depthPyramid = std::make_unique<Image>(m_device->Get(), *m_device->GetAllocator(), m_device->GetRegistry(), extent,
+        VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT, VK_IMAGE_ASPECT_COLOR_BIT, m_levelCount, 1, std::source_location::current());
+
+    std::array<VkDescriptorSetLayoutBinding, 5> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_device->Get(), &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create hole fill descriptor set layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
+
+    uint32_t setCount = m_levelCount - 1;
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSize.descriptorCount = setCount * static_cast<uint32_t>(bindings.size());
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = setCount;
+
+    if (vkCreateDescriptorPool(m_device->Get(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create hole fill descriptor pool!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+
+    std::vector<VkDescriptorSetLayout> setLayouts(setCount, m_descriptorSetLayout);
+    m_descriptorSets.resize(setCount);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = setCount;
+    allocInfo.pSetLayouts = setLayouts.data();
+
+    if (vkAllocateDescriptorSets(m_device->Get(), &allocInfo, m_descriptorSets.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate hole fill descriptor sets!");
+
+    for (uint32_t level = 0; level < setCount; ++level)
+    {
+        std::array<VkDescriptorImageInfo, 5> imageInfos{};
+        imageInfos[0].imageView = target->GetView();
+        imageInfos[1].imageView = m_colorPyramid->GetMipView(level);
+        imageInfos[2].imageView = m_depthPyramid->GetMipView(level);
+        imageInfos[3].imageView = m_colorPyramid->GetMipView(level + 1);
+        imageInfos[4].imageView = m_depthPyramid->GetMipView(level + 1);
+
+        std::array<VkWriteDescriptorSet, 5> writes{};
+        for (uint32_t i = 0; i < writes.size(); ++i)
+        {
+            imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = m_descriptorSets[level];
+            writes[i].dstBinding = i;
+            writes[i].dstArrayElement = 0;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[i].descriptorCount = 1;
+            writes[i].pImageInfo = &imageInfos[i];
+        }
+
+        vkUpdateDescriptorSets(m_device->Get(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(HoleFillPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+
+    if (vkCreatePipelineLayout(m_device->Get(), &pipelineLayoutInfo, nullptr, &m_layout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create hole fill pipeline layout!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
+
+    VkShaderModule shader = Shaders::CreateModule(m_device->Get(), Shaders::PointCloudFill);
+
+    VkPipelineShaderStageCreateInfo stage{};
+    stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage.module = shader;
+    stage.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = stage;
+    pipelineInfo.layout = m_layout;
+
+    if (vkCreateComputePipelines(m_device->Get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create hole fill pipeline!");
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
+
+    vkDestroyShaderModule(m_device->Get(), shader, nullptr);
+}
+
+HoleFiller::~HoleFiller()
+{
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE, m_pipeline);
+    vkDestroyPipeline(m_device->Get(), m_pipeline, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_layout);
+    vkDestroyPipelineLayout(m_device->Get(), m_layout, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_POOL, m_descriptorPool);
+    vkDestroyDescriptorPool(m_device->Get(), m_descriptorPool, nullptr);
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, m_descriptorSetLayout);
+    vkDestroyDescriptorSetLayout(m_device->Get(), m_descriptorSetLayout, nullptr);
+}
+
+void HoleFiller::Record(VkCommandBuffer cmd)
+{
+    // Every level is rewritten within the rendered region each frame, so previous contents are discarded
+    std::array<VkImageMemoryBarrier, 2> toGeneral{};
+    Image* pyramids[] = { m_colorPyramid.get(), m_depthPyramid.get() };
+    for (uint32_t i = 0; i < toGeneral.size(); ++i)
+    {
+        toGeneral[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        toGeneral[i].srcAccessMask = 0;
+        toGeneral[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        toGeneral[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        toGeneral[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        toGeneral[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toGeneral[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toGeneral[i].image = pyramids[i]->Get();
+        toGeneral[i].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_levelCount, 0, 1 };
+    }
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(toGeneral.size()), toGeneral.data());
+
+    // Region of each level covered by the current render extent
+    std::vector<VkExtent2D> regions(m_levelCount);
+    regions[0] = m_renderPass->GetRenderExtent();
+    for (uint32_t level = 1; level < m_levelCount; ++level)
+    {
+        VkExtent2D mip = m_colorPyramid->GetMipExtent(level);
+        regions[level].width = std::min((regions[level - 1].width + 1) / 2, mip.width);
+        regions[level].height = std::min((regions[level - 1].height + 1) / 2, mip.height);
+    }
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+    Dispatch(cmd, MODE_GATHER, 0, regions);
+    for (uint32_t level = 0; level + 1 < m_levelCount; ++level)
+        Dispatch(cmd, MODE_PULL, level, regions);
+    for (uint32_t level = m_levelCount - 1; level-- > 0;)
+        Dispatch(cmd, MODE_PUSH, level, regions);
+}
+
+void HoleFiller::Dispatch(VkCommandBuffer cmd, uint32_t mode, uint32_t level, const std::vector<VkExtent2D>& regions)
+{
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &m_descriptorSets[level], 0, nullptr);
+
+    HoleFillPushConstants pc{};
+    pc.mode = mode;
+    pc.level = level;
+    pc.fineWidth = regions[level].width;
+    pc.fineHeight = regions[level].height;
+    pc.coarseWidth = regions[level + 1].width;
+    pc.coarseHeight = regions[level + 1].height;
+    pc.depthThreshold = DEPTH_THRESHOLD;
+    pc.minCoverage = MIN_COVERAGE;
+    vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HoleFillPushConstants), &pc);
+
+    // Pull writes the coarse level, gather and push write the fine one
+    VkExtent2D written = mode == MODE_PULL ? regions[level + 1] : regions[level];
+    vkCmdDispatch(cmd, (written.width + GROUP_SIZE - 1) / GROUP_SIZE, (written.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+}
@@ -0,0 +1,130 @@
+#include "Image.h"
+
+// STD
+#include <algorithm>
+#include <stdexcept>
+
+Image::Image(VkDevice device,
+    const MemoryAllocator& allocator,
+    std::shared_ptr<ResourceRegistry> registry,
+    VkExtent2D extent,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    VkImageAspectFlags aspect,
+    uint32_t mipLevels,
+    uint32_t arrayLayers,
+    std::source_location site)
+    : m_device(device), m_registry(registry), m_format(format), m_extent(extent), m_mipLevels(mipLevels), m_arrayLayers(arrayLayers)
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = arrayLayers;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &m_image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create image!");
+    }
+    m_registry->Track(VK_OBJECT_TYPE_IMAGE, m_image, 0, site);
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, m_image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = allocator.FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &m_memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate image memory!");
+    }
+    m_registry->Track(VK_OBJECT_TYPE_DEVICE_MEMORY, m_memory, memRequirements.size, site);
+
+    vkBindImageMemory(device, m_image, m_memory, 0);
+
+    m_view = CreateView(0, mipLevels, aspect, site);
+
+    // Storage images can only bind a single mip level, so each level gets its own view
+    if (mipLevels > 1)
+    {
+        for (uint32_t level = 0; level < mipLevels; ++level)
+        {
+            m_mipViews.push_back(CreateView(level, 1, aspect, site));
+        }
+    }
+    else
+    {
+        m_mipViews.push_back(m_view);
+    }
+}
+
+Image::~Image()
+{
+    if (m_mipLevels > 1)
+    {
+        for (auto view : m_mipViews)
+        {
+            m_registry->Untrack(VK_OBJECT_TYPE_IMAGE_VIEW, view);
+            vkDestroyImageView(m_device, view, nullptr);
+        }
+    }
+
+    if (m_view != VK_NULL_HANDLE)
+    {
+        m_registry->Untrack(VK_OBJECT_TYPE_IMAGE_VIEW, m_view);
+        vkDestroyImageView(m_device, m_view, nullptr);
+    }
+
+    if (m_image != VK_NULL_HANDLE)
+    {
+        m_registry->Untrack(VK_OBJECT_TYPE_IMAGE, m_image);
+        vkDestroyImage(m_device, m_image, nullptr);
+    }
+
+    if (m_memory != VK_NULL_HANDLE)
+    {
+        m_registry->Untrack(VK_OBJECT_TYPE_DEVICE_MEMORY, m_memory);
+        vkFreeMemory(m_device, m_memory, nullptr);
+    }
+}
+
+VkExtent2D Image::GetMipExtent(uint32_t level) const
+{
+    VkExtent2D extent{};
+    extent.width = std::max(m_extent.width >> level, 1u);
+    extent.height = std::max(m_extent.height >> level, 1u);
+    return extent;
+}
+
+VkImageView Image::CreateView(uint32_t baseMip, uint32_t mipCount, VkImageAspectFlags aspect, std::source_location site) const
+{
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_image;
+    // Layered images are viewed as arrays so multiview render passes can target every layer
+    viewInfo.viewType = m_arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = m_format;
+    viewInfo.subresourceRange.aspectMask = aspect;
+    viewInfo.subresourceRange.baseMipLevel = baseMip;
+    viewInfo.subresourceRange.levelCount = mipCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = m_arrayLayers;
+
+    VkImageView view;
+    if (vkCreateImageView(m_device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create image view!");
+    }
+    m_registry->Track(VK_OBJECT_TYPE_IMAGE_VIEW, view, 0, site);
+
+    return view;
+}
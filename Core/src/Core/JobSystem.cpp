@@ -0,0 +1,253 @@
+#include "JobSystem.h"
+
+// STD
+#include <algorithm>
+
+namespace
+{
+    // Which job system, if any, the calling thread works for
+    struct WorkerIdentity
+    {
+        const JobSystem* system = nullptr;
+        int index = -1;
+    };
+
+    thread_local WorkerIdentity t_worker;
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    if (workerCount == 0)
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    m_workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+
+    // Started only once every deque exists, workers steal from each other right away
+    for (uint32_t i = 0; i < workerCount; ++i)
+        m_workers[i]->thread = std::thread(&JobSystem::WorkerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+        worker->thread.join();
+}
+
+int JobSystem::GetWorkerIndex() const
+{
+    return t_worker.system == this ? t_worker.index : -1;
+}
+
+JobSystem::JobHandle JobSystem::Schedule(JobFunction function, std::span<const JobHandle> dependencies)
+{
+    JobHandle job = std::make_shared<Job>();
+    job->function = std::move(function);
+
+    for (const auto& dependency : dependencies)
+    {
+        if (!dependency)
+            continue;
+
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->done)
+        {
+            dependency->dependents.push_back(job);
+            job->pendingDependencies++;
+        }
+    }
+
+    // Drop the scheduling guard, whoever brings the count to zero queues the job
+    if (--job->pendingDependencies == 0)
+        Enqueue(job);
+
+    return job;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+    int worker = GetWorkerIndex();
+    while (!job->done)
+    {
+        // Help with other work rather than blocking, the job may depend on it
+        if (JobHandle other = TryTakeJob(worker))
+        {
+            Execute(other, worker);
+            continue;
+        }
+
+        // Nothing to take, sleep until a job finishes or more work is queued. Registering before checking pairs with
+        // Execute and Enqueue setting their state before reading the count, so neither wake-up can be missed.
+        m_waiters++;
+        {
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_progress.wait(lock, [this, &job]() { return job->done || m_queued > 0; });
+        }
+        m_waiters--;
+    }
+
+    if (job->exception)
+        std::rethrow_exception(job->exception);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function)
+{
+    batchSize = std::max(batchSize, 1u);
+
+    std::vector<JobHandle> batches;
+    batches.reserve((count + batchSize - 1) / batchSize);
+    for (uint32_t begin = 0; begin < count; begin += batchSize)
+    {
+        uint32_t end = std::min(begin + batchSize, count);
+        batches.push_back(Schedule([&function, begin, end]() { function(begin, end); }));
+    }
+
+    // Every batch references function, so all of them have to finish before an exception leaves this frame
+    std::exception_ptr exception;
+    for (const auto& batch : batches)
+    {
+        try
+        {
+            Wait(batch);
+        }
+        catch (...)
+        {
+            if (!exception)
+                exception = std::current_exception();
+        }
+    }
+
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void JobSystem::WorkerMain(uint32_t index)
+{
+    t_worker = { this, static_cast<int>(index) };
+
+    while (!m_stop)
+    {
+        if (JobHandle job = TryTakeJob(static_cast<int>(index)))
+        {
+            Execute(job, static_cast<int>(index));
+            continue;
+        }
+
+        if (m_hooks.idle)
+            m_hooks.idle(static_cast<int>(index));
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+    }
+}
+
+void JobSystem::Enqueue(JobHandle job)
+{
+    // Workers push onto their own deque to keep related jobs local, other threads spread jobs round robin
+    int worker = GetWorkerIndex();
+    uint32_t target = worker >= 0 ? static_cast<uint32_t>(worker) : m_nextWorker++ % GetWorkerCount();
+
+    {
+        std::lock_guard<std::mutex> lock(m_workers[target]->mutex);
+        m_workers[target]->jobs.push_back(std::move(job));
+    }
+
+    {
+        // Taken so a worker cannot miss the wake-up between checking the count and sleeping
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued++;
+    }
+    m_wake.notify_one();
+    if (m_waiters > 0)
+        m_progress.notify_all();
+}
+
+JobSystem::JobHandle JobSystem::TryTakeJob(int worker)
+{
+    uint32_t workerCount = GetWorkerCount();
+
+    if (worker >= 0)
+    {
+        Worker& own = *m_workers[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            JobHandle job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            m_queued--;
+            return job;
+        }
+    }
+
+    // Steal the oldest job, it is the most likely to spawn further work
+    uint32_t start = worker >= 0 ? static_cast<uint32_t>(worker) + 1 : 0;
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        uint32_t victim = (start + i) % workerCount;
+        if (static_cast<int>(victim) == worker)
+            continue;
+
+        Worker& other = *m_workers[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.jobs.empty())
+        {
+            JobHandle job = std::move(other.jobs.front());
+            other.jobs.pop_front();
+            m_queued--;
+            m_stolen++;
+
+            if (m_hooks.steal)
+                m_hooks.steal(worker, static_cast<int>(victim));
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::Execute(const JobHandle& job, int worker)
+{
+    if (m_hooks.jobBegin)
+        m_hooks.jobBegin(worker);
+
+    // A throwing job must not take the worker down with it, the exception is handed to whoever waits on the job
+    try
+    {
+        job->function();
+    }
+    catch (...)
+    {
+        job->exception = std::current_exception();
+    }
+    m_executed++;
+
+    if (m_hooks.jobEnd)
+        m_hooks.jobEnd(worker);
+
+    std::vector<JobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        dependents.swap(job->dependents);
+    }
+
+    if (m_waiters > 0)
+    {
+        // The lock orders the notification after a waiter's check of done, or before it starts checking
+        { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+        m_progress.notify_all();
+    }
+
+    for (auto& dependent : dependents)
+    {
+        if (--dependent->pendingDependencies == 0)
+            Enqueue(std::move(dependent));
+    }
+}
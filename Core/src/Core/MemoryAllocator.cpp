@@ -0,0 +1,447 @@
+#include "MemoryAllocator.h"
+
+// STD
+#include <algorithm>
+#include <stdexcept>
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, std::shared_ptr<ResourceRegistry> registry, VkDeviceSize blockSize)
+	: m_device(device), m_registry(registry), m_blockSize(MIN_ALLOCATION)
+{
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    // Buddy levels halve the block, so it has to be a power of two
+    while (m_blockSize * 2 <= blockSize)
+        m_blockSize *= 2;
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    // Freeing the memory also unmaps it
+    for (auto& block : m_blocks)
+    {
+        if (block)
+            FreeMemory(block->memory);
+    }
+}
+
+MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool dedicated)
+{
+    return Allocate(requirements, properties, dedicated, VK_NULL_HANDLE);
+}
+
+MemoryAllocation MemoryAllocator::AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 requirements{};
+    requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    requirements.pNext = &dedicatedRequirements;
+
+    VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.buffer = buffer;
+    vkGetBufferMemoryRequirements2(m_device, &requirementsInfo, &requirements);
+
+    bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    MemoryAllocation allocation = Allocate(requirements.memoryRequirements, properties, dedicated, buffer);
+
+    if (vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+    {
+        Free(allocation);
+        throw std::runtime_error("Failed to bind buffer memory!");
+    }
+
+    return allocation;
+}
+
+MemoryAllocation MemoryAllocator::ImportHostMemory(VkBuffer buffer, const void* hostPointer, VkDeviceSize size, uint32_t memoryTypeBits)
+{
+    MemoryAllocation allocation{};
+    allocation.size = size;
+    allocation.block = -1;
+
+    // Coherent types spare the application flushing its writes, which it could not do without a mapping
+    try
+    {
+        allocation.memoryType = FindMemoryType(memoryTypeBits, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+    catch (const std::runtime_error&)
+    {
+        allocation.memoryType = FindMemoryType(memoryTypeBits, 0);
+    }
+
+    VkImportMemoryHostPointerInfoEXT importInfo{};
+    importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    importInfo.pHostPointer = const_cast<void*>(hostPointer);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = &importInfo;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = allocation.memoryType;
+
+    if (vkAllocateMemory(m_device, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to import host memory!");
+    }
+    m_registry->Track(VK_OBJECT_TYPE_DEVICE_MEMORY, allocation.memory, size);
+
+    if (vkBindBufferMemory(m_device, buffer, allocation.memory, 0) != VK_SUCCESS)
+    {
+        FreeMemory(allocation.memory);
+        throw std::runtime_error("Failed to bind imported host memory!");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dedicatedCount++;
+    m_dedicatedBytes += size;
+    m_dedicatedHeapBytes[m_memoryProperties.memoryTypes[allocation.memoryType].heapIndex] += size;
+    m_allocationCount++;
+    m_requestedBytes += size;
+    return allocation;
+}
+
+MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool dedicated, VkBuffer dedicatedBuffer)
+{
+    MemoryAllocation allocation{};
+    allocation.size = requirements.size;
+    allocation.memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+
+    // Alignments are powers of two, a range at least that large is aligned by construction
+    VkDeviceSize needed = std::max({ requirements.size, requirements.alignment, MIN_ALLOCATION });
+    VkDeviceSize blockSize = GetBlockSize(allocation.memoryType);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (dedicated || needed > blockSize / 2)
+    {
+        allocation.memory = AllocateMemory(requirements.size, allocation.memoryType, dedicatedBuffer, &allocation.mapped);
+        allocation.block = -1;
+
+        m_dedicatedCount++;
+        m_dedicatedBytes += requirements.size;
+        m_dedicatedHeapBytes[m_memoryProperties.memoryTypes[allocation.memoryType].heapIndex] += requirements.size;
+        m_allocationCount++;
+        m_requestedBytes += requirements.size;
+        return allocation;
+    }
+
+    allocation.level = GetLevel(blockSize, needed);
+
+    int32_t freeSlot = -1;
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+        Block* block = m_blocks[i].get();
+        if (!block)
+        {
+            if (freeSlot < 0)
+                freeSlot = static_cast<int32_t>(i);
+            continue;
+        }
+
+        if (block->memoryType == allocation.memoryType && AllocateFromBlock(*block, allocation.level, allocation.offset))
+        {
+            allocation.block = static_cast<int32_t>(i);
+            break;
+        }
+    }
+
+    if (allocation.block < 0)
+    {
+        auto block = std::make_unique<Block>();
+        block->memoryType = allocation.memoryType;
+        block->size = blockSize;
+        block->memory = AllocateMemory(blockSize, allocation.memoryType, VK_NULL_HANDLE, &block->mapped);
+        block->freeLists.resize(GetLevel(blockSize, MIN_ALLOCATION) + 1);
+        block->freeLists[0].insert(0);
+
+        AllocateFromBlock(*block, allocation.level, allocation.offset);
+
+        if (freeSlot < 0)
+        {
+            freeSlot = static_cast<int32_t>(m_blocks.size());
+            m_blocks.push_back(nullptr);
+        }
+        m_blocks[freeSlot] = std::move(block);
+        allocation.block = freeSlot;
+    }
+
+    const Block& block = *m_blocks[allocation.block];
+    allocation.memory = block.memory;
+    allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + allocation.offset : nullptr;
+
+    m_allocationCount++;
+    m_requestedBytes += requirements.size;
+    return allocation;
+}
+
+void MemoryAllocator::Free(const MemoryAllocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_allocationCount--;
+    m_requestedBytes -= allocation.size;
+
+    if (allocation.block < 0)
+    {
+        FreeMemory(allocation.memory);
+        m_dedicatedCount--;
+        m_dedicatedBytes -= allocation.size;
+        m_dedicatedHeapBytes[m_memoryProperties.memoryTypes[allocation.memoryType].heapIndex] -= allocation.size;
+        return;
+    }
+
+    Block& block = *m_blocks[allocation.block];
+    block.used -= block.size >> allocation.level;
+
+    // Merge with the buddy for as long as it is free as well
+    VkDeviceSize offset = allocation.offset;
+    uint32_t level = allocation.level;
+    while (level > 0)
+    {
+        VkDeviceSize buddy = offset ^ (block.size >> level);
+        if (block.freeLists[level].erase(buddy) == 0)
+            break;
+
+        offset = std::min(offset, buddy);
+        level--;
+    }
+    block.freeLists[level].insert(offset);
+
+    if (block.used == 0)
+    {
+        // One empty block per memory type is kept, so allocations that come and go at a block boundary, such as
+        // growing staging buffers, do not allocate and free device memory every time
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+        {
+            const Block* other = m_blocks[i].get();
+            if (other && other != &block && other->memoryType == block.memoryType && other->used == 0)
+            {
+                FreeMemory(block.memory);
+                m_blocks[allocation.block].reset();
+                return;
+            }
+        }
+    }
+}
+
+bool MemoryAllocator::ShouldMove(const MemoryAllocation& allocation) const
+{
+    if (allocation.memory == VK_NULL_HANDLE || allocation.block < 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const Block& source = *m_blocks[allocation.block];
+    if (source.used * 2 > source.size)
+        return false;
+
+    for (const auto& block : m_blocks)
+    {
+        if (block && block.get() != &source && IsMoveTarget(*block, source, allocation.level))
+            return true;
+    }
+    return false;
+}
+
+MemoryAllocation MemoryAllocator::AllocateMoveTarget(VkBuffer buffer, const MemoryAllocation& source)
+{
+    MemoryAllocation allocation{};
+    if (source.memory == VK_NULL_HANDLE || source.block < 0)
+        return allocation;
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(m_device, buffer, &requirements);
+    if (!(requirements.memoryTypeBits & (1u << source.memoryType)))
+        return allocation;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const Block& sourceBlock = *m_blocks[source.block];
+        VkDeviceSize needed = std::max({ requirements.size, requirements.alignment, MIN_ALLOCATION });
+        uint32_t level = GetLevel(sourceBlock.size, needed);
+
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+        {
+            Block* block = m_blocks[i].get();
+            if (!block || block == &sourceBlock || !IsMoveTarget(*block, sourceBlock, level))
+                continue;
+
+            if (AllocateFromBlock(*block, level, allocation.offset))
+            {
+                allocation.size = requirements.size;
+                allocation.memoryType = source.memoryType;
+                allocation.block = static_cast<int32_t>(i);
+                allocation.level = level;
+                allocation.memory = block->memory;
+                allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + allocation.offset : nullptr;
+
+                m_allocationCount++;
+                m_requestedBytes += requirements.size;
+                break;
+            }
+        }
+    }
+
+    if (allocation.memory != VK_NULL_HANDLE && vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+    {
+        Free(allocation);
+        throw std::runtime_error("Failed to bind buffer memory!");
+    }
+
+    return allocation;
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+MemoryStats MemoryAllocator::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    MemoryStats stats{};
+    for (const auto& block : m_blocks)
+    {
+        if (!block)
+            continue;
+
+        stats.blockCount++;
+        stats.reservedBytes += block->size;
+        stats.usedBytes += block->used;
+    }
+
+    stats.dedicatedCount = m_dedicatedCount;
+    stats.allocationCount = m_allocationCount;
+    stats.reservedBytes += m_dedicatedBytes;
+    stats.usedBytes += m_dedicatedBytes;
+    stats.requestedBytes = m_requestedBytes;
+    return stats;
+}
+
+VkDeviceSize MemoryAllocator::GetHeapReservedBytes(uint32_t heapIndex) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    VkDeviceSize reserved = m_dedicatedHeapBytes[heapIndex];
+    for (const auto& block : m_blocks)
+    {
+        if (block && m_memoryProperties.memoryTypes[block->memoryType].heapIndex == heapIndex)
+            reserved += block->size;
+    }
+    return reserved;
+}
+
+VkDeviceMemory MemoryAllocator::AllocateMemory(VkDeviceSize size, uint32_t memoryType, VkBuffer dedicatedBuffer, void** mapped)
+{
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.buffer = dedicatedBuffer;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = dedicatedBuffer != VK_NULL_HANDLE ? &dedicatedInfo : nullptr;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult result = vkAllocateMemory(m_device, &allocInfo, nullptr, &memory);
+    if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY)
+    {
+        throw OutOfDeviceMemoryError();
+    }
+    else if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate device memory!");
+    }
+
+    // Memory can only be mapped once, so host-visible memory is mapped as a whole for every range in it
+    *mapped = nullptr;
+    if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+        {
+            vkFreeMemory(m_device, memory, nullptr);
+            throw std::runtime_error("Failed to map device memory!");
+        }
+    }
+
+    m_registry->Track(VK_OBJECT_TYPE_DEVICE_MEMORY, memory, size);
+    return memory;
+}
+
+void MemoryAllocator::FreeMemory(VkDeviceMemory memory)
+{
+    m_registry->Untrack(VK_OBJECT_TYPE_DEVICE_MEMORY, memory);
+    vkFreeMemory(m_device, memory, nullptr);
+}
+
+VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryType) const
+{
+    // Small heaps, such as device-local host-visible windows, are not claimed by a single block
+    VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryType].heapIndex].size;
+
+    VkDeviceSize blockSize = m_blockSize;
+    while (blockSize > MIN_ALLOCATION * 2 && blockSize > heapSize / 8)
+        blockSize /= 2;
+
+    return blockSize;
+}
+
+uint32_t MemoryAllocator::GetLevel(VkDeviceSize blockSize, VkDeviceSize size) const
+{
+    uint32_t level = 0;
+    while ((blockSize >> (level + 1)) >= std::max(size, MIN_ALLOCATION))
+        level++;
+
+    return level;
+}
+
+bool MemoryAllocator::AllocateFromBlock(Block& block, uint32_t level, VkDeviceSize& offset)
+{
+    // Take the smallest free range that fits and split it down to the requested level
+    int32_t source = static_cast<int32_t>(level);
+    while (source >= 0 && block.freeLists[source].empty())
+        source--;
+
+    if (source < 0)
+        return false;
+
+    offset = *block.freeLists[source].begin();
+    block.freeLists[source].erase(block.freeLists[source].begin());
+
+    for (uint32_t split = static_cast<uint32_t>(source) + 1; split <= level; ++split)
+        block.freeLists[split].insert(offset + (block.size >> split));
+
+    block.used += block.size >> level;
+    return true;
+}
+
+bool MemoryAllocator::IsMoveTarget(const Block& block, const Block& source, uint32_t level) const
+{
+    // Moving only into blocks at least as full keeps allocations from moving back and forth
+    if (block.memoryType != source.memoryType || block.used < source.used)
+        return false;
+
+    for (uint32_t i = 0; i <= level && i < block.freeLists.size(); ++i)
+    {
+        if (!block.freeLists[i].empty())
+            return true;
+    }
+    return false;
+}
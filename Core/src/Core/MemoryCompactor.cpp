@@ -0,0 +1,119 @@
+#include "MemoryCompactor.h"
+
+// STD
+#include <algorithm>
+
+MemoryCompactor::MemoryCompactor(VkDeviceSize bytesPerFrame)
+	: m_bytesPerFrame(bytesPerFrame)
+{
+}
+
+void MemoryCompactor::Register(const std::shared_ptr<Buffer>& buffer, Rebind rebind, bool preserveContents)
+{
+    m_entries.push_back({ buffer, std::move(rebind), preserveContents });
+}
+
+bool MemoryCompactor::HasMoves() const
+{
+    for (const Entry& entry : m_entries)
+    {
+        auto buffer = entry.buffer.lock();
+        if (buffer && buffer->ShouldMove())
+            return true;
+    }
+    return false;
+}
+
+VkDeviceSize MemoryCompactor::Record(VkCommandBuffer cmd, uint64_t frame, VkPipelineStageFlags readStages, VkAccessFlags readAccess)
+{
+    m_frame = frame;
+
+    std::erase_if(m_entries, [](const Entry& entry) { return entry.buffer.expired(); });
+
+    // Each move keeps the original until the frame completes, so the budget also bounds the memory held twice
+    struct Move
+    {
+        Entry* entry;
+        std::shared_ptr<Buffer> source;
+        std::shared_ptr<Buffer> target;
+    };
+    std::vector<Move> moves;
+    VkDeviceSize movedBytes = 0;
+    for (Entry& entry : m_entries)
+    {
+        auto source = entry.buffer.lock();
+        if (!source->ShouldMove() || (movedBytes > 0 && movedBytes + source->GetSize() > m_bytesPerFrame))
+            continue;
+
+        auto target = source->CreateMoveTarget();
+        if (!target)
+            continue;
+
+        moves.push_back({ &entry, source, target });
+        movedBytes += source->GetSize();
+    }
+
+    if (moves.empty())
+        return 0;
+
+    // Copies earlier in the command buffer, such as point updates, may have written the sources, so their writes are
+    // made visible to the copies. Earlier frames reading the sources only need execution order.
+    VkMemoryBarrier transferBarrier{};
+    transferBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    transferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    transferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        readStages | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &transferBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    std::vector<VkBufferMemoryBarrier> barriers;
+    for (const Move& move : moves)
+    {
+        if (!move.entry->preserveContents)
+            continue;
+
+        VkBufferCopy region{};
+        region.size = move.source->GetSize();
+        vkCmdCopyBuffer(cmd, move.source->Get(), move.target->Get(), 1, &region);
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = readAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = move.target->Get();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barriers.push_back(barrier);
+    }
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        readStages,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data(),
+        0, nullptr);
+
+    // The frame is recorded after this, so it already binds the targets
+    for (Move& move : moves)
+    {
+        move.entry->buffer = move.target;
+        move.entry->rebind(move.target);
+        Retire(std::move(move.source));
+    }
+
+    return movedBytes;
+}
+
+void MemoryCompactor::Release(uint64_t completedFrame)
+{
+    while (!m_retired.empty() && m_retired.front().first <= completedFrame)
+        m_retired.pop_front();
+}
@@ -3,7 +3,7 @@
 // PCR
 #include "Utils.h"
 
-Mesh::Mesh(const char* filepath)
+Mesh::Mesh(const char* filepath, JobSystem* jobs)
 {
 	if (!tinyobj::LoadObj(&m_attributes, &m_shapes, &m_materials, &m_warning, &m_error, filepath)) 
 	{
@@ -11,21 +11,40 @@ Mesh::Mesh(const char* filepath)
 		Utils::ThrowFatalError(message.c_str());
 	}
 
+    size_t triangleCount = 0;
+    for (const auto& shape : m_shapes)
+        triangleCount += shape.mesh.indices.size() / 3;
+    triangles.resize(triangleCount);
+
+    size_t firstTriangle = 0;
     for (const auto& shape : m_shapes)
     {
-        for (size_t f = 0; f < shape.mesh.indices.size(); f += 3)
+        uint32_t shapeTriangles = static_cast<uint32_t>(shape.mesh.indices.size() / 3);
+
+        // Every face writes its own triangle, so ranges of faces convert independently
+        auto convert = [&](uint32_t begin, uint32_t end)
         {
-            tinyobj::index_t i0 = shape.mesh.indices[f + 0];
-            tinyobj::index_t i1 = shape.mesh.indices[f + 1];
-            tinyobj::index_t i2 = shape.mesh.indices[f + 2];
-
-            triangles.push_back
-            ({
-                glm::vec4(m_attributes.vertices[3 * i0.vertex_index + 0], m_attributes.vertices[3 * i0.vertex_index + 1], m_attributes.vertices[3 * i0.vertex_index + 2], 0),
-                glm::vec4(m_attributes.vertices[3 * i1.vertex_index + 0], m_attributes.vertices[3 * i1.vertex_index + 1], m_attributes.vertices[3 * i1.vertex_index + 2], 0),
-                glm::vec4(m_attributes.vertices[3 * i2.vertex_index + 0], m_attributes.vertices[3 * i2.vertex_index + 1], m_attributes.vertices[3 * i2.vertex_index + 2], 0)
-            });
-        }
+            for (uint32_t t = begin; t < end; ++t)
+            {
+                tinyobj::index_t i0 = shape.mesh.indices[3 * t + 0];
+                tinyobj::index_t i1 = shape.mesh.indices[3 * t + 1];
+                tinyobj::index_t i2 = shape.mesh.indices[3 * t + 2];
+
+                triangles[firstTriangle + t] =
+                {
+                    glm::vec4(m_attributes.vertices[3 * i0.vertex_index + 0], m_attributes.vertices[3 * i0.vertex_index + 1], m_attributes.vertices[3 * i0.vertex_index + 2], 0),
+                    glm::vec4(m_attributes.vertices[3 * i1.vertex_index + 0], m_attributes.vertices[3 * i1.vertex_index + 1], m_attributes.vertices[3 * i1.vertex_index + 2], 0),
+                    glm::vec4(m_attributes.vertices[3 * i2.vertex_index + 0], m_attributes.vertices[3 * i2.vertex_index + 1], m_attributes.vertices[3 * i2.vertex_index + 2], 0)
+                };
+            }
+        };
+
+        if (jobs)
+            jobs->ParallelFor(shapeTriangles, 4096, convert);
+        else
+            convert(0, shapeTriangles);
+
+        firstTriangle += shapeTriangles;
     }
 
     if (triangles.empty())
@@ -3,95 +3,419 @@
 // PCR
 #include "Utils.h"
 
+// STD
+#include <algorithm>
+#include <cmath>
+
 // VULKAN
 #include <vulkan/vulkan.h>
 
-RenderPass::RenderPass(Device* device, Swapchain* swapchain)
-	: m_device(device->Get()), m_extent(swapchain->GetExtent()), m_swapchain(swapchain)
+namespace
+{
+    // Mandatory for color attachments, storage images and blit sources
+    constexpr VkFormat SPLAT_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+RenderPass::RenderPass(Device* device, Swapchain* swapchain, const RenderPassSettings& settings)
+	: m_device(device->Get()), m_physicalDevice(device->GetPhysicalDevice()), m_allocator(device->GetAllocator()), m_registry(device->GetRegistry()), m_swapchain(swapchain), m_swapchainFormat(swapchain->GetFormat()), m_settings(settings)
 {
-	CreateRenderPass(swapchain->GetFormat());
+	// Splats are written to an offscreen target and need depth testing to keep the nearest point per pixel
+	if (m_settings.splatting)
+	{
+		m_settings.offscreen = true;
+		m_settings.depth = true;
+	}
+
+	// Views are rendered into layers of an offscreen target, then laid out as a grid of tiles
+	m_settings.viewCount = std::max(m_settings.viewCount, 1u);
+	if (m_settings.viewCount > 1)
+	{
+		m_settings.offscreen = true;
+		m_tileColumns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_settings.viewCount))));
+	}
+
+	if (m_settings.depth)
+		m_depthFormat = FindDepthFormat();
+
+	UpdateExtents(swapchain->GetExtent());
+	CreateRenderPass(m_swapchainFormat);
 	CreateFramebuffers(swapchain->GetImageViews());
 }
 
 RenderPass::~RenderPass()
 {
-    for (auto fb : m_framebuffers) 
-    {
-        vkDestroyFramebuffer(m_device, fb, nullptr);
-    }
+    DestroyFramebuffers();
 
     if (m_renderPass != VK_NULL_HANDLE) 
     {
+        m_registry->Untrack(VK_OBJECT_TYPE_RENDER_PASS, m_renderPass);
         vkDestroyRenderPass(m_device, m_renderPass, nullptr);
     }
 }
 
-void RenderPass::Begin(VkCommandBuffer cmd, uint32_t imageIndex)
+bool RenderPass::Resize(Swapchain* swapchain)
+{
+    // The attachment formats are baked into the render pass and every pipeline built against it
+    if (swapchain->GetFormat() != m_swapchainFormat)
+        return false;
+
+    DestroyFramebuffers();
+
+    m_swapchain = swapchain;
+    UpdateExtents(swapchain->GetExtent());
+    CreateFramebuffers(swapchain->GetImageViews());
+    return true;
+}
+
+void RenderPass::Begin(VkCommandBuffer cmd, uint32_t imageIndex, VkSubpassContents contents)
 {
     VkRenderPassBeginInfo renderInfo{};
     renderInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderInfo.renderPass = m_renderPass;
-	renderInfo.framebuffer = GetFramebuffers()[imageIndex];
+	renderInfo.framebuffer = GetFramebuffer(imageIndex);
     renderInfo.renderArea.offset = { 0,0 };
-    renderInfo.renderArea.extent = m_swapchain->GetExtent();
-    VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-    renderInfo.clearValueCount = 1;
-    renderInfo.pClearValues = &clearColor;
+    renderInfo.renderArea.extent = m_renderExtent;
+    VkClearValue clearValues[2]{};
+    // Splat targets use alpha for view depth, zero marks pixels without a point
+    clearValues[0].color = { {0.0f, 0.0f, 0.0f, m_settings.splatting ? 0.0f : 1.0f} };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    renderInfo.clearValueCount = m_settings.depth ? 2 : 1;
+    renderInfo.pClearValues = clearValues;
+
+    vkCmdBeginRenderPass(cmd, &renderInfo, contents);
+}
+
+void RenderPass::Resolve(VkCommandBuffer cmd, uint32_t imageIndex)
+{
+    if (!m_settings.offscreen)
+        return;
+
+    VkImage swapchainImage = m_swapchain->GetImages()[imageIndex];
+
+    if (m_settings.splatting)
+    {
+        VkImageMemoryBarrier targetToTransfer{};
+        targetToTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        targetToTransfer.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        targetToTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        targetToTransfer.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        targetToTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        targetToTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        targetToTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        targetToTransfer.image = m_colorTarget->Get();
+        targetToTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, VK_REMAINING_ARRAY_LAYERS };
+
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &targetToTransfer);
+    }
+
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = swapchainImage;
+    toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &toTransfer);
+
+    // Tiles may not cover the whole image, so the remainder is cleared rather than left undefined
+    if (m_settings.viewCount > 1)
+    {
+        VkClearColorValue clearColor = { {0.0f, 0.0f, 0.0f, 1.0f} };
+        vkCmdClearColorImage(cmd, swapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &toTransfer.subresourceRange);
+
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &clearBarrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    std::vector<VkImageBlit> blits(m_settings.viewCount);
+    for (uint32_t view = 0; view < m_settings.viewCount; ++view)
+    {
+        VkRect2D tile = GetViewTile(view);
+
+        blits[view].srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, view, 1 };
+        blits[view].srcOffsets[1] = { static_cast<int32_t>(m_renderExtent.width), static_cast<int32_t>(m_renderExtent.height), 1 };
+        blits[view].dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        blits[view].dstOffsets[0] = { tile.offset.x, tile.offset.y, 0 };
+        blits[view].dstOffsets[1] = { tile.offset.x + static_cast<int32_t>(tile.extent.width), tile.offset.y + static_cast<int32_t>(tile.extent.height), 1 };
+    }
+
+    vkCmdBlitImage(cmd,
+        m_colorTarget->Get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        swapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(blits.size()), blits.data(), VK_FILTER_LINEAR);
+
+    VkImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toPresent.dstAccessMask = 0;
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &toPresent);
+}
+
+bool RenderPass::SupportsOffscreen(Device* device, Swapchain* swapchain)
+{
+    if (!(swapchain->GetUsage() & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+        return false;
+
+    VkFormatProperties formatProps;
+    vkGetPhysicalDeviceFormatProperties(device->GetPhysicalDevice(), swapchain->GetFormat(), &formatProps);
+
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProps.optimalTilingFeatures & required) == required;
+}
+
+void RenderPass::SetRenderExtent(VkExtent2D extent)
+{
+    // Only offscreen targets can be rendered at a reduced size, the swapchain is always drawn in full
+    if (!m_settings.offscreen)
+        return;
+
+    m_renderExtent.width = std::min(extent.width, m_targetExtent.width);
+    m_renderExtent.height = std::min(extent.height, m_targetExtent.height);
+}
 
-    vkCmdBeginRenderPass(cmd, &renderInfo, VK_SUBPASS_CONTENTS_INLINE);
+VkRect2D RenderPass::GetViewTile(uint32_t view) const
+{
+    if (m_settings.viewCount == 1)
+        return { { 0, 0 }, m_extent };
+
+    VkRect2D tile{};
+    tile.offset.x = static_cast<int32_t>((view % m_tileColumns) * m_targetExtent.width);
+    tile.offset.y = static_cast<int32_t>((view / m_tileColumns) * m_targetExtent.height);
+    tile.extent = m_targetExtent;
+    return tile;
 }
 
 void RenderPass::CreateRenderPass(VkFormat swapchainFormat)
 {
     VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapchainFormat;
+    colorAttachment.format = m_settings.splatting ? SPLAT_FORMAT : swapchainFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = m_settings.splatting ? VK_IMAGE_LAYOUT_GENERAL :
+        m_settings.offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+    // Depth is only needed within the pass, so it is never stored
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = m_depthFormat;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthAttachmentRef{};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = m_settings.depth ? &depthAttachmentRef : nullptr;
+
+    VkAttachmentDescription attachments[] = { colorAttachment, depthAttachment };
+
+    // Offscreen and depth targets are shared by all frames: order their writes after the previous frame's use,
+    // and make the offscreen target visible to this frame's blit
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    // The previous frame's blit reads the offscreen target on the transfer stage before this pass overwrites it.
+    // A write-after-read hazard only needs an execution dependency, so there is no access to make available, but
+    // the previous frame's color writes are still flushed before they are overwritten.
+    if (m_settings.offscreen)
+    {
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[0].srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+
+    if (m_settings.splatting)
+    {
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        dependencies[0].srcAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+
+    if (m_settings.depth)
+    {
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[0].dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
+
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    if (m_settings.splatting)
+    {
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    }
 
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.attachmentCount = m_settings.depth ? 2 : 1;
+    renderPassInfo.pAttachments = attachments;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = m_settings.offscreen ? 2 : 1;
+    renderPassInfo.pDependencies = dependencies;
+
+    // Every draw is broadcast to all views, gl_ViewIndex selects the camera in the vertex shader
+    uint32_t viewMask = (1u << m_settings.viewCount) - 1u;
+
+    VkRenderPassMultiviewCreateInfo multiviewInfo{};
+    multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+    multiviewInfo.subpassCount = 1;
+    multiviewInfo.pViewMasks = &viewMask;
+    multiviewInfo.correlationMaskCount = 1;
+    multiviewInfo.pCorrelationMasks = &viewMask;
+
+    if (m_settings.viewCount > 1)
+        renderPassInfo.pNext = &multiviewInfo;
 
     if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS) 
     {
         Utils::ThrowFatalError("Failed to create render pass!");
     }
+    m_registry->Track(VK_OBJECT_TYPE_RENDER_PASS, m_renderPass);
+}
+
+void RenderPass::UpdateExtents(VkExtent2D extent)
+{
+    m_extent = extent;
+    m_targetExtent = extent;
+    if (m_settings.viewCount > 1)
+    {
+        uint32_t rows = (m_settings.viewCount + m_tileColumns - 1) / m_tileColumns;
+        m_targetExtent.width = std::max(m_extent.width / m_tileColumns, 1u);
+        m_targetExtent.height = std::max(m_extent.height / rows, 1u);
+    }
+    m_renderExtent = m_targetExtent;
+}
+
+void RenderPass::DestroyFramebuffers()
+{
+    for (auto fb : m_framebuffers) 
+    {
+        m_registry->Untrack(VK_OBJECT_TYPE_FRAMEBUFFER, fb);
+        vkDestroyFramebuffer(m_device, fb, nullptr);
+    }
+
+    m_framebuffers.clear();
+    m_colorTarget.reset();
+    m_depthTarget.reset();
 }
 
 void RenderPass::CreateFramebuffers(const std::vector<VkImageView>& imageViews)
 {
-    m_framebuffers.resize(imageViews.size());
-    for (size_t i = 0; i < imageViews.size(); ++i) 
+    std::vector<VkImageView> colorViews = imageViews;
+    if (m_settings.offscreen)
+    {
+        // Allocated at full output size so the render extent can change without reallocating
+        VkFormat format = m_settings.splatting ? SPLAT_FORMAT : m_swapchain->GetFormat();
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        if (m_settings.splatting)
+            usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+        m_colorTarget = std::make_unique<Image>(m_device, *m_allocator, m_registry, m_targetExtent, format, usage, VK_IMAGE_ASPECT_COLOR_BIT, 1, m_settings.viewCount, std::source_location::current());
+        colorViews = { m_colorTarget->GetView() };
+    }
+
+    if (m_settings.depth)
+    {
+        m_depthTarget = std::make_unique<Image>(m_device, *m_allocator, m_registry, m_targetExtent, m_depthFormat,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            VK_IMAGE_ASPECT_DEPTH_BIT, 1, m_settings.viewCount, std::source_location::current());
+    }
+
+    m_framebuffers.resize(colorViews.size());
+    for (size_t i = 0; i < colorViews.size(); ++i) 
     {
+        VkImageView attachments[] = { colorViews[i], m_depthTarget ? m_depthTarget->GetView() : VK_NULL_HANDLE };
+
         VkFramebufferCreateInfo framebufferInfo{};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass = m_renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = &imageViews[i];
-        framebufferInfo.width = m_extent.width;
-        framebufferInfo.height = m_extent.height;
+        framebufferInfo.attachmentCount = m_settings.depth ? 2 : 1;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = m_targetExtent.width;
+        framebufferInfo.height = m_targetExtent.height;
+        // Multiview addresses the layers through the view mask, the framebuffer itself stays single-layered
         framebufferInfo.layers = 1;
 
         if (vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &m_framebuffers[i]) != VK_SUCCESS) 
         {
             Utils::ThrowFatalError("Failed to create framebuffer!");
         }
+        m_registry->Track(VK_OBJECT_TYPE_FRAMEBUFFER, m_framebuffers[i]);
     }
 }
+
+VkFormat RenderPass::FindDepthFormat() const
+{
+    // D16_UNORM is guaranteed to support depth attachments
+    const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM };
+    for (VkFormat format : candidates)
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &props);
+        if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            return format;
+    }
+
+    return VK_FORMAT_D16_UNORM;
+}
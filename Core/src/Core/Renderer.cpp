@@ -1,16 +1,18 @@
 #include "Renderer.h"
 
 // PCR
-#include "CommandBuffers.h"
 #include "PushConstants.h"
 #include "Triangle.h"
 #include "Utils.h"
 
 // STD
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 
@@ -19,6 +21,7 @@
 
 // GLM
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 // TINYOBJ
@@ -27,6 +30,24 @@
 // WIN32
 #include <Windows.h>
 
+namespace
+{
+    // Release (on the source queue) or acquire (on the destination queue) half of a buffer's queue family ownership transfer
+    VkBufferMemoryBarrier QueueOwnershipBarrier(VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+    {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        return barrier;
+    }
+}
+
 Renderer::Renderer(std::shared_ptr<Window> window)
     : m_window(window)
 {
@@ -35,12 +56,12 @@ Renderer::Renderer(std::shared_ptr<Window> window)
         Utils::ThrowFatalError("Invalid or null window pointer passed to renderer!");
     }
 
+    m_jobSystem = std::make_shared<JobSystem>();
+
     m_instance = std::make_shared<Instance>(window.get());
     m_surface = m_instance->CreateVulkanSurface(window.get());
 
     m_device = std::make_shared<Device>(m_instance->Get(), m_surface);
-    m_swapChain = std::make_shared<Swapchain>(m_device.get(), window.get());
-    m_renderPass = std::make_shared<RenderPass>(m_device.get(), m_swapChain.get());
 }
 
 Renderer::~Renderer()
@@ -54,249 +75,1148 @@ Renderer::~Renderer()
 
 void Renderer::LoadMesh(const char* modelPath)
 {
-	m_mesh = Mesh(modelPath);
+	m_mesh = Mesh(modelPath, m_jobSystem.get());
 	m_triangles = m_mesh.GetTriangles();
 	m_meshLoaded = true;
+
+	// Bounds the depth range used to order clusters front to back, reduced per batch then across batches
+	const uint32_t batchSize = 4096;
+	uint32_t triangleCount = static_cast<uint32_t>(m_triangles.size());
+	std::vector<float> batchRadii((triangleCount + batchSize - 1) / batchSize, 0.0f);
+
+	m_jobSystem->ParallelFor(triangleCount, batchSize, [&](uint32_t begin, uint32_t end)
+	{
+		float radius = 0.0f;
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const Triangle& triangle = m_triangles[i];
+			radius = std::max({ radius, glm::length(glm::vec3(triangle.v0)), glm::length(glm::vec3(triangle.v1)), glm::length(glm::vec3(triangle.v2)) });
+		}
+		batchRadii[begin / batchSize] = radius;
+	});
+
+	m_meshRadius = 0.0f;
+	for (float radius : batchRadii)
+		m_meshRadius = std::max(m_meshRadius, radius);
 }
 
 void Renderer::Init()
 {
-    if (!m_meshLoaded)
+    if (!m_meshLoaded && m_points.empty())
     {
-		Utils::ThrowFatalError("Mesh not loaded before initializing renderer!");
+		Utils::ThrowFatalError("Neither a mesh nor points set before initializing renderer!");
     }
 
-    VkDevice device = m_device->Get();
-    VkPhysicalDevice physicalDevice = m_device->GetPhysicalDevice();
+    m_cameraDistance = m_window->CameraDistance;
+    m_windowExtent = { m_window->GetWidth(), m_window->GetHeight() };
+
+    m_swapChain = std::make_shared<Swapchain>(m_device.get(), m_windowExtent, nullptr, m_presentPolicy);
+    m_stats.presentMode = m_swapChain->GetPresentMode();
+
+    if (m_dynamicResolution && !RenderPass::SupportsOffscreen(m_device.get(), m_swapChain.get()))
+    {
+        std::cerr << "[Renderer] Swapchain cannot be blitted to, dynamic resolution disabled" << std::endl;
+        m_dynamicResolution = false;
+    }
 
-    m_triangleBuffer = std::make_unique<Buffer>(
-        device,
-        physicalDevice,
-        sizeof(Triangle) * m_triangles.size(),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
-    m_triangleBuffer->CopyData(m_triangles.data(), sizeof(Triangle) * m_triangles.size());
+    if (m_splatting && !RenderPass::SupportsOffscreen(m_device.get(), m_swapChain.get()))
+    {
+        std::cerr << "[Renderer] Swapchain cannot be blitted to, splatting disabled" << std::endl;
+        m_splatting = false;
+    }
 
-    m_particleBuffer = std::make_unique<Buffer>(
-        device,
-        physicalDevice,
-        sizeof(glm::vec4) * m_particleCount,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-    );
+    if (m_viewCount > 1)
+    {
+        uint32_t maxViews = std::min(m_device->GetMaxMultiviewViewCount(), MAX_VIEWS);
+        if (!m_device->SupportsMultiview() || !RenderPass::SupportsOffscreen(m_device.get(), m_swapChain.get()))
+        {
+            std::cerr << "[Renderer] Multiview unsupported, rendering a single view" << std::endl;
+            m_viewCount = 1;
+        }
+        else if (m_viewCount > maxViews)
+        {
+            std::cerr << "[Renderer] Multiview limited to " << maxViews << " views" << std::endl;
+            m_viewCount = maxViews;
+        }
+    }
 
-    m_descriptorPool = std::make_shared<DescriptorPool>(m_device, m_renderPass, m_swapChain, m_triangleBuffer, m_particleBuffer);
-    m_commandBuffers = m_descriptorPool->GetCommandBuffers();
-	m_computePipeline = std::make_shared<ComputePipeline>(m_descriptorPool, m_device);
-	m_graphicsPipeline = std::make_shared<GraphicsPipeline>(m_renderPass, m_swapChain, m_device);
+    if (m_viewCount > 1 && m_splatting)
+    {
+        std::cerr << "[Renderer] Hole filling works on a single view, splatting disabled for multiview" << std::endl;
+        m_splatting = false;
+    }
 
-    m_imageCount = static_cast<uint32_t>(m_swapChain->GetImageViews().size());
-    m_imageAvailable.resize(m_imageCount);
-    m_renderFinished.resize(m_imageCount);
-    m_inFlightFences.resize(m_imageCount);
-    m_imagesInFlight.resize(m_imageCount, VK_NULL_HANDLE);
+    if (m_asyncCompute && !m_device->HasAsyncCompute())
+    {
+        std::cerr << "[Renderer] No dedicated compute queue family, particles are generated on the graphics queue" << std::endl;
+        m_asyncCompute = false;
+    }
 
-    for (uint32_t i = 0; i < m_imageCount; ++i) 
+    if (m_asyncCompute && m_prerecordCommands)
+    {
+        std::cerr << "[Renderer] Async compute alternates particle buffers per frame, disabled with prerecorded commands" << std::endl;
+        m_asyncCompute = false;
+    }
+
+    if (m_drawBatches > 1 && m_prerecordCommands)
+    {
+        std::cerr << "[Renderer] Prerecorded commands are recorded once, parallel recording disabled" << std::endl;
+        m_drawBatches = 1;
+    }
+
+    if ((m_depthTest || m_splatting) && m_frontToBack && !ClusterSorter::IsSupported(m_device.get()))
+    {
+        std::cerr << "[Renderer] multiDrawIndirect unsupported, clusters are drawn unordered" << std::endl;
+        m_frontToBack = false;
+    }
+
+    m_renderPass = std::make_shared<RenderPass>(m_device.get(), m_swapChain.get(), GetRenderPassSettings());
+
+    // The triangles are read by every dispatch, so they live in device-local memory. The copy runs on the
+    // transfer queue while the rest of the renderer is created and is only waited for before the first frame.
+    m_uploadService = std::make_shared<UploadService>(m_device);
+    UploadTicket triangleUpload;
+    if (m_meshLoaded)
+    {
+        m_triangleBuffer = m_uploadService->CreateBuffer(
+            m_triangles.data(),
+            sizeof(Triangle) * m_triangles.size(),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            { m_device->GetGraphicsFamilyIndex(), m_device->GetComputeFamilyIndex() },
+            triangleUpload
+        );
+    }
+    else
+    {
+        m_particleCount = 0;
+    }
+
+    // Created before the particles so copied points count against the memory budget
+    UploadTicket pointUpload = CreatePointBuffers();
+
+    // The estimate ignores allocation rounding and memory taken meanwhile by other processes, so running out of
+    // device memory retries with half the particles before giving up. Other failures would not fit any better.
+    ClampParticleCount();
+    while (true)
+    {
+        try
+        {
+            CreateParticleSets();
+            break;
+        }
+        catch (const OutOfDeviceMemoryError&)
+        {
+            DestroyParticleSets();
+            if (m_particleCount <= WORK_GROUP_SIZE)
+                throw;
+
+            m_particleCount /= 2;
+            std::cerr << "[Renderer] Particle buffers could not be allocated, retrying with " << m_particleCount << " particles" << std::endl;
+        }
+    }
+    m_stats.particleCount = m_particleCount;
+
+    // Prerecorded frames are submitted from the per-image command buffers instead
+    if (!m_prerecordCommands)
+        m_commandBuffers = std::make_shared<CommandBuffers>(m_device.get(), m_device->GetGraphicsFamilyIndex(), m_maxFramesInFlight);
+    if (m_asyncCompute)
+        m_computeCommandBuffers = std::make_shared<CommandBuffers>(m_device.get(), m_device->GetComputeFamilyIndex(), m_maxFramesInFlight);
+    // Point updates and compaction copies are recorded into a command buffer of their own, submitted ahead of the
+    // frame's, so they also reach prerecorded frames
+    if (m_dynamicPoints && !m_pointRanges.empty())
+        m_pointUpdater = std::make_shared<BufferUpdater>(m_device, m_maxFramesInFlight);
+    if (m_memoryCompaction)
+        RegisterCompaction();
+    if (m_pointUpdater || m_memoryCompactor)
+        m_updateCommandBuffers = std::make_shared<CommandBuffers>(m_device.get(), m_device->GetGraphicsFamilyIndex(), m_maxFramesInFlight);
+    // Pools are created for each thread the first time it records a batch
+    if (m_drawBatches > 1)
+        m_secondaryCommandBuffers = std::make_shared<SecondaryCommandBuffers>(m_device.get(), m_device->GetGraphicsFamilyIndex(), m_maxFramesInFlight);
+
+    CreateImageSemaphores();
+    CreateFrameSlots();
+
+	if (!m_particleSets[0].chunks.empty())
+		m_computePipeline = std::make_shared<ComputePipeline>(m_particleSets[0].chunks[0].descriptorPool, m_device, m_frameUniforms->GetDescriptorSetLayout());
+	m_graphicsPipeline = std::make_shared<GraphicsPipeline>(m_renderPass, m_device, m_frameUniforms->GetDescriptorSetLayout());
+
+    // Tiny targets are drawn without hole filling
+    if (m_splatting && HoleFiller::CanFill(m_renderPass->GetColorTarget()->GetExtent()))
+        m_holeFiller = std::make_shared<HoleFiller>(m_device, m_renderPass, m_fillLevels);
+
+    m_frameScheduler = std::make_shared<FrameScheduler>(m_device, m_maxFramesInFlight);
+    m_imageAvailable.resize(m_maxFramesInFlight);
+
+    for (uint32_t i = 0; i < m_maxFramesInFlight; ++i) 
     {
         VkSemaphoreCreateInfo semInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
         if (vkCreateSemaphore(m_device->Get(), &semInfo, nullptr, &m_imageAvailable[i]) != VK_SUCCESS)
 			Utils::ThrowFatalError("Failed to create imageAvailable semaphore.");
-        if (vkCreateSemaphore(m_device->Get(), &semInfo, nullptr, &m_renderFinished[i]) != VK_SUCCESS)
-            Utils::ThrowFatalError("Failed to create renderFinished semaphore.");
-
-        VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-        if (vkCreateFence(m_device->Get(), &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
-            Utils::ThrowFatalError("Failed to create inFlight fence.");
+        m_device->GetRegistry()->Track(VK_OBJECT_TYPE_SEMAPHORE, m_imageAvailable[i]);
     }
+
+    // The fence wait makes the copied triangles and points available to the first submissions on the other queues
+    m_uploadService->Wait(triangleUpload);
+    m_uploadService->Wait(pointUpload);
 }
 
 void Renderer::Run()
 {
+    if (m_quit)
+        return;
+
+    // Paced before any other work so the frame samples input as late as its deadline allows
+    m_stats.pacingSleepMs = m_framePacer.Wait();
+
+    // Bounds how far the CPU runs ahead; once the slot's last frame is done its command pool, semaphore and timestamps are free again
+    uint64_t frame = m_frameScheduler->BeginFrame();
+    m_currentFrame = m_frameScheduler->GetSlot();
+    ReleaseRetiredSwapchains();
+
+    // A bounded wait lets the render thread see Quit when no image becomes available, e.g. while the window is hidden.
+    // Nothing was signaled or submitted on a timeout, so the next call begins the same frame again.
     uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(m_device->Get(), m_swapChain->Get(), UINT64_MAX,
+    VkResult result = vkAcquireNextImageKHR(m_device->Get(), m_swapChain->Get(), ACQUIRE_TIMEOUT_NS,
         m_imageAvailable[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) 
+    if (result == VK_TIMEOUT || result == VK_NOT_READY)
     {
-        m_window->FramebufferResized = false;
+        return;
+    }
+    else if (result == VK_ERROR_OUT_OF_DATE_KHR) 
+    {
+        m_framebufferResized = false;
         RecreateSwapchain();
+        return;
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) 
     {
         Utils::ThrowFatalError("Failed to acquire swapchain image.");
     }
 
-    if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(m_device->Get(), 1, &m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    // The image may still be rendered by an older frame when there are more images than frames in flight
+    m_frameScheduler->WaitForFrame(m_imageFrames[imageIndex]);
+    m_imageFrames[imageIndex] = frame;
+
+    // Sampled after every wait of the frame so the camera is as recent as possible when recording starts
+    ProcessCommands();
+
+    // Prerecorded command buffers belong to a swapchain image, so the per-frame data they read does too
+    uint32_t slot = m_prerecordCommands ? imageIndex : m_currentFrame;
+
+    m_frameClock.Tick();
+    UpdateFrameTiming(slot);
+    WriteFrameUniforms(slot);
+
+    // Every point change made since the last frame, merged into as few copies as possible
+    VkCommandBuffer updateCmd = VK_NULL_HANDLE;
+    m_stats.pointUpdateBytes = 0;
+    if (m_pointUpdater && m_pointUpdater->HasPending())
+    {
+        updateCmd = m_updateCommandBuffers->Begin(m_currentFrame);
+        m_stats.pointUpdateBytes = m_pointUpdater->Record(updateCmd, m_currentFrame, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
     }
-    m_imagesInFlight[imageIndex] = m_inFlightFences[m_currentFrame];
 
-    vkWaitForFences(m_device->Get(), 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
-    vkResetFences(m_device->Get(), 1, &m_inFlightFences[m_currentFrame]);
+    // Compaction has to follow the point updates so moved buffers carry them, and precede recording so the frame binds
+    // the new buffers
+    m_stats.compactedBytes = 0;
+    if (m_memoryCompactor)
+    {
+        m_memoryCompactor->Release(m_frameScheduler->GetCompletedFrame());
+        if (m_memoryCompactor->HasMoves())
+        {
+            if (updateCmd == VK_NULL_HANDLE)
+                updateCmd = m_updateCommandBuffers->Begin(m_currentFrame);
+            m_stats.compactedBytes = m_memoryCompactor->Record(updateCmd, frame,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        }
+    }
 
-    VkCommandBuffer cmd = m_commandBuffers->Get()[imageIndex];
-    vkResetCommandBuffer(cmd, 0);
+    if (updateCmd != VK_NULL_HANDLE && vkEndCommandBuffer(updateCmd) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to record update command buffer.");
 
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = 0;
-    beginInfo.pInheritanceInfo = nullptr;
-    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
-        Utils::ThrowFatalError("Failed to begin command buffer.");
+    ParticleSet& particles = m_particleSets[m_particleSetIndex];
+    if (m_asyncCompute)
+        SubmitParticles(slot, particles);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline->Get());
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline->GetLayout(), 0, 1, m_descriptorPool->GetComputeDescriptorSet(), 0, nullptr);
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    if (m_prerecordCommands)
+    {
+        // The viewport, blit regions and cluster depth range are baked into the recorded commands
+        VkExtent2D renderExtent = m_renderPass->GetRenderExtent();
+        if (renderExtent.width != m_recordedExtent.width || renderExtent.height != m_recordedExtent.height ||
+            m_clusterDepthRange != m_recordedDepthRange)
+        {
+            std::fill(m_recorded.begin(), m_recorded.end(), false);
+            m_recordedExtent = renderExtent;
+            m_recordedDepthRange = m_clusterDepthRange;
+        }
 
-    ComputePushConstants compPC{};
-    compPC.time = static_cast<float>(clock() / static_cast<double>(CLOCKS_PER_SEC));
-    compPC.numTriangles = static_cast<uint32_t>(m_triangles.size());
-    vkCmdPushConstants(cmd, m_computePipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ComputePushConstants), &compPC);
+        // This image's previous submission has completed, so its command buffer can be re-recorded
+        if (!m_recorded[imageIndex])
+        {
+            RecordFrame(m_imageCommandBuffers->Begin(imageIndex), imageIndex, slot, particles);
+            m_recorded[imageIndex] = true;
+        }
 
-    vkCmdDispatch(cmd, (m_particleCount + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, 1, 1);
+        cmd = m_imageCommandBuffers->Get(imageIndex);
+    }
+    else
+    {
+        cmd = m_commandBuffers->Begin(m_currentFrame);
+        RecordFrame(cmd, imageIndex, slot, particles);
+    }
 
-    VkMemoryBarrier memBarrier{};
-    memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-    memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    memBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    VkSemaphore waitSemaphores[] = { m_imageAvailable[m_currentFrame], particles.generated };
+    VkSemaphore signalSemaphores[] = { m_renderFinished[imageIndex], m_frameScheduler->GetTimeline() };
+    // Binary semaphores ignore their values
+    uint64_t waitValues[] = { 0, 0 };
+    uint64_t signalValues[] = { 0, frame };
+    // Offscreen rendering only touches the swapchain image in the final blit
+    VkPipelineStageFlags waitStages[] = {
+        m_renderPass->IsOffscreen() ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+    };
 
-    vkCmdPipelineBarrier(cmd,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-        0,
-        1, &memBarrier,
-        0, nullptr,
-        0, nullptr);
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = m_asyncCompute ? 2 : 1;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = 2;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
 
-    m_renderPass->Begin(cmd, imageIndex);
+    // With async compute the frame also waits for its particles. Signaling the timeline completes the frame.
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = m_asyncCompute ? 2 : 1;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    // Barriers in the update command buffer order it against the frames before and the frame after it
+    VkCommandBuffer cmds[] = { updateCmd, cmd };
+    submitInfo.commandBufferCount = updateCmd != VK_NULL_HANDLE ? 2 : 1;
+    submitInfo.pCommandBuffers = updateCmd != VK_NULL_HANDLE ? cmds : &cmd;
+    submitInfo.signalSemaphoreCount = 2;
+    submitInfo.pSignalSemaphores = signalSemaphores;
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline->Get());
+    if (vkQueueSubmit(m_device->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to submit draw command buffer.");
 
-    VkDeviceSize offsets[] = { 0 };
-    VkBuffer vb = m_particleBuffer->Get();
-    vkCmdBindVertexBuffers(cmd, 0, 1, &vb, offsets);
+    m_frameScheduler->EndFrame();
+    m_stats.submittedFrame = frame;
+    m_stats.completedFrame = m_frameScheduler->GetCompletedFrame();
 
-    GraphicsPushConstants gfxPC{};
+    particles.drawnFrame = frame;
+    m_particleSetIndex = (m_particleSetIndex + 1) % static_cast<uint32_t>(m_particleSets.size());
+
+    VkPresentInfoKHR presentInfo{};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = signalSemaphores;
+    VkSwapchainKHR scs[] = { m_swapChain->Get() };
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = scs;
+    presentInfo.pImageIndices = &imageIndex;
+
+    VkResult pres = vkQueuePresentKHR(m_device->GetPresentQueue(), &presentInfo);
+    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR || m_framebufferResized) 
+    {
+        m_framebufferResized = false;
+        RecreateSwapchain();
+    }
+    else if (pres != VK_SUCCESS) 
+    {
+        Utils::ThrowFatalError("Failed to present swapchain image.");
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_publishedStats = m_stats;
+}
+
+void Renderer::WriteFrameUniforms(uint32_t slot)
+{
+    // Each view renders into its own tile, so the aspect ratio follows the target rather than the window
+    VkExtent2D targetExtent = m_renderPass->GetTargetExtent();
     glm::mat4 proj = glm::perspective(glm::radians(45.0f),
-        (float)m_swapChain->GetExtent().width / (float)m_swapChain->GetExtent().height,
+        (float)targetExtent.width / (float)targetExtent.height,
         0.1f, 100.0f);
 
-    float angle = m_rotationSpeed * static_cast<float>(clock()) / CLOCKS_PER_SEC;
+    float angle = m_rotationSpeed * static_cast<float>(m_frameClock.GetTime());
     glm::mat4 model = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
 
     proj[1][1] *= -1.0f;
 
-    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, m_window->CameraDistance), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    gfxPC.mvp = proj * view * model;
-    vkCmdPushConstants(cmd, m_graphicsPipeline->GetLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GraphicsPushConstants), &gfxPC);
+    FrameUniformData data{};
+    data.time = static_cast<float>(m_frameClock.GetTime());
 
-    vkCmdDraw(cmd, m_particleCount, 1, 0, 0);
+    std::array<ViewCamera, MAX_VIEWS> cameras;
+    {
+        std::lock_guard<std::mutex> lock(m_viewMutex);
+        cameras = m_viewCameras;
+    }
 
-    vkCmdEndRenderPass(cmd);
+    // Unless placed by the application, view 0 is the main camera and further views orbit the mesh at the same distance
+    float nearest = std::numeric_limits<float>::max();
+    float farthest = 0.0f;
+    for (uint32_t i = 0; i < m_viewCount; ++i)
+    {
+        if (!cameras[i].placed)
+        {
+            float yaw = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(m_viewCount);
+            cameras[i].eye = m_cameraDistance * glm::vec3(std::sin(yaw), 0.0f, std::cos(yaw));
+            cameras[i].target = glm::vec3(0.0f);
+        }
+
+        glm::mat4 view = glm::lookAt(cameras[i].eye, cameras[i].target, glm::vec3(0.0f, 1.0f, 0.0f));
+        data.mvp[i] = proj * view * model;
+
+        float distance = glm::length(cameras[i].eye);
+        nearest = std::min(nearest, distance);
+        farthest = std::max(farthest, distance);
+    }
+
+    // Clusters can only be as near or as far as the mesh bounds allow, whichever way the cameras look
+    m_clusterDepthRange = glm::vec2(std::max(nearest - m_meshRadius, 0.0f), farthest + m_meshRadius);
+
+    m_frameUniforms->Write(slot, data);
+}
+
+void Renderer::RecordParticles(VkCommandBuffer cmd, uint32_t slot, ParticleSet& particles)
+{
+    // Only the application's points are drawn when no mesh is loaded
+    if (particles.chunks.empty())
+        return;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline->Get());
+
+    // Chunks write disjoint buffers, so their dispatches need no barriers between them
+    for (auto& chunk : particles.chunks)
+    {
+        VkDescriptorSet computeSets[] = { *chunk.descriptorPool->GetComputeDescriptorSet(), *m_frameUniforms->GetDescriptorSet(slot) };
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline->GetLayout(), 0, 2, computeSets, 0, nullptr);
+
+        ComputePushConstants compPC{};
+        compPC.numTriangles = static_cast<uint32_t>(m_triangles.size());
+        compPC.numParticles = m_particleCount;
+        compPC.firstParticle = chunk.firstParticle;
+        compPC.chunkParticles = chunk.particleCount;
+        compPC.clusterOrder = chunk.clusterSorter ? 1u : 0u;
+        compPC.viewCount = m_viewCount;
+        vkCmdPushConstants(cmd, m_computePipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ComputePushConstants), &compPC);
+
+        VkExtent3D grid = ComputePipeline::GetDispatchGrid(m_device.get(), (chunk.particleCount + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE);
+        vkCmdDispatch(cmd, grid.width, grid.height, grid.depth);
+    }
+}
+
+void Renderer::RecordParticleBarriers(VkCommandBuffer cmd, ParticleSet& particles, bool release)
+{
+    // Release on the compute queue after generation, acquire on the graphics queue before drawing
+    std::vector<VkBufferMemoryBarrier> barriers;
+    barriers.reserve(particles.chunks.size() * 2);
+    for (auto& chunk : particles.chunks)
+    {
+        barriers.push_back(QueueOwnershipBarrier(chunk.particles->Get(), m_device->GetComputeFamilyIndex(), m_device->GetGraphicsFamilyIndex(),
+            release ? VK_ACCESS_SHADER_WRITE_BIT : 0, release ? 0 : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT));
+        barriers.push_back(QueueOwnershipBarrier(chunk.clusterDepths->Get(), m_device->GetComputeFamilyIndex(), m_device->GetGraphicsFamilyIndex(),
+            release ? VK_ACCESS_SHADER_WRITE_BIT : 0, release ? 0 : VK_ACCESS_SHADER_READ_BIT));
+    }
+
+    vkCmdPipelineBarrier(cmd,
+        release ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data(),
+        0, nullptr);
+}
+
+uint32_t Renderer::GetParticleChunkCapacity() const
+{
+    // Bounded by the largest storage buffer binding, and kept moderate so chunks fit in the allocator's
+    // dedicated allocations and the memory budget degrades in small steps
+    const VkDeviceSize maxChunkBytes = 256ull * 1024 * 1024;
+    VkDeviceSize chunkBytes = std::min<VkDeviceSize>(m_device->GetProperties().limits.maxStorageBufferRange, maxChunkBytes);
+
+    // Whole workgroups per chunk, so every cluster lies in a single chunk
+    uint32_t capacity = static_cast<uint32_t>(chunkBytes / sizeof(glm::vec4));
+    return std::max(capacity / WORK_GROUP_SIZE, 1u) * WORK_GROUP_SIZE;
+}
+
+void Renderer::SubmitParticles(uint32_t slot, ParticleSet& particles)
+{
+    // The slot's last frame has completed, and with it the compute submission its rendering waited for
+    VkCommandBuffer cmd = m_computeCommandBuffers->Begin(m_currentFrame);
+
+    // Every particle and cluster depth is rewritten, so the set is used here without acquiring it back from graphics
+    RecordParticles(cmd, slot, particles);
+    RecordParticleBarriers(cmd, particles, true);
 
     if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
-        Utils::ThrowFatalError("Failed to record command buffer.");
+        Utils::ThrowFatalError("Failed to record compute command buffer.");
+
+    // Rendering of the frame that last drew this set must finish before it is overwritten, waiting on the frame
+    // timeline keeps that on the GPU instead of blocking the host
+    VkSemaphore timeline = m_frameScheduler->GetTimeline();
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    uint64_t signalValue = 0;
 
-    VkSemaphore waitSemaphores[] = { m_imageAvailable[m_currentFrame] };
-    VkSemaphore signalSemaphores[] = { m_renderFinished[m_currentFrame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = &particles.drawnFrame;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
     submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.pWaitSemaphores = &timeline;
+    submitInfo.pWaitDstStageMask = &waitStage;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmd;
     submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    submitInfo.pSignalSemaphores = &particles.generated;
 
-    if (vkQueueSubmit(m_device->GetGraphicsQueue(), 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
-        Utils::ThrowFatalError("Failed to submit draw command buffer.");
+    if (vkQueueSubmit(m_device->GetComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to submit compute command buffer.");
+}
 
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
-    VkSwapchainKHR scs[] = { m_swapChain->Get() };
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = scs;
-    presentInfo.pImageIndices = &imageIndex;
+void Renderer::RecordFrame(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t slot, ParticleSet& particles)
+{
+    if (m_gpuTimer)
+        m_gpuTimer->Begin(cmd, slot);
 
-    VkResult pres = vkQueuePresentKHR(m_device->GetPresentQueue(), &presentInfo);
-    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR || m_window->FramebufferResized) 
+    if (m_asyncCompute)
     {
-        m_window->FramebufferResized = false;
-        RecreateSwapchain();
+        // Acquire the particles released by the compute queue, the submission already waited for them
+        RecordParticleBarriers(cmd, particles, false);
     }
-    else if (pres != VK_SUCCESS) 
+    else
     {
-        Utils::ThrowFatalError("Failed to present swapchain image.");
+        // The previous frame's reads of the particle and cluster buffers must finish before they are regenerated
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            0, nullptr);
+
+        RecordParticles(cmd, slot, particles);
+
+        VkMemoryBarrier memBarrier{};
+        memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            1, &memBarrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    for (auto& chunk : particles.chunks)
+    {
+        if (chunk.clusterSorter)
+            chunk.clusterSorter->Record(cmd, m_clusterDepthRange.x, m_clusterDepthRange.y);
+    }
+
+    if (m_secondaryCommandBuffers)
+    {
+        m_renderPass->Begin(cmd, imageIndex, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        RecordDrawBatches(cmd, imageIndex, slot, particles);
+    }
+    else
+    {
+        m_renderPass->Begin(cmd, imageIndex);
+        RecordDraws(cmd, slot, particles, 0, 1);
     }
 
-    m_currentFrame = (m_currentFrame + 1) % m_imageCount;
+    vkCmdEndRenderPass(cmd);
+
+    if (m_holeFiller)
+        m_holeFiller->Record(cmd);
+
+    m_renderPass->Resolve(cmd, imageIndex);
+
+    if (m_gpuTimer)
+        m_gpuTimer->End(cmd, slot);
+
+    if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+        Utils::ThrowFatalError("Failed to record command buffer.");
+}
+
+void Renderer::RecordDrawBatches(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t slot, ParticleSet& particles)
+{
+    // The slot's previous frame has completed, so its secondary buffers can be recycled
+    m_secondaryCommandBuffers->Reset(slot);
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = m_renderPass->Get();
+    inheritance.subpass = 0;
+    inheritance.framebuffer = m_renderPass->GetFramebuffer(imageIndex);
+
+    // Each batch is recorded into the pool of whichever thread runs it: a worker, the render thread while it waits,
+    // or any other thread waiting on the shared job system
+    std::vector<VkCommandBuffer> batches(m_drawBatches, VK_NULL_HANDLE);
+    m_jobSystem->ParallelFor(m_drawBatches, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t batch = begin; batch < end; ++batch)
+        {
+            VkCommandBuffer secondary = m_secondaryCommandBuffers->Begin(slot, inheritance);
+            RecordDraws(secondary, slot, particles, batch, m_drawBatches);
+            if (vkEndCommandBuffer(secondary) != VK_SUCCESS)
+                Utils::ThrowFatalError("Failed to record secondary command buffer.");
+            batches[batch] = secondary;
+        }
+    });
+
+    // Executed in batch order, which keeps the front-to-back cluster order intact
+    vkCmdExecuteCommands(cmd, m_drawBatches, batches.data());
+}
+
+void Renderer::RecordDraws(VkCommandBuffer cmd, uint32_t slot, ParticleSet& particles, uint32_t batch, uint32_t batchCount)
+{
+    // Secondary command buffers inherit no state, every batch binds everything it draws with
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline->Get());
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline->GetLayout(), 0, 1, m_frameUniforms->GetDescriptorSet(slot), 0, nullptr);
+    GraphicsPipeline::SetViewport(cmd, m_renderPass->GetRenderExtent());
+
+    GraphicsPushConstants gfxPC{};
+    // Splats stay small so gaps are left to the hole filler rather than covered by overlapping points
+    gfxPC.pointSize = m_splatting ? 1.0f : 2.0f;
+    // Pixels per unit of spacing at view distance 1 for the 45 degree vertical field of view
+    gfxPC.pointScale = m_splatting && m_adaptivePointSize
+        ? static_cast<float>(m_renderPass->GetRenderExtent().height) / (2.0f * std::tan(glm::radians(45.0f) * 0.5f))
+        : 0.0f;
+    vkCmdPushConstants(cmd, m_graphicsPipeline->GetLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GraphicsPushConstants), &gfxPC);
+
+    // Batches split the chunks' draws taken in sequence, sorted chunks contribute clusters and unsorted ones particles.
+    // Executing the batches in order draws the chunks one after another, each in its front-to-back order.
+    // The application's point ranges follow the chunks, unsorted.
+    uint64_t totalUnits = 0;
+    for (const auto& chunk : particles.chunks)
+        totalUnits += chunk.clusterSorter ? chunk.clusterSorter->GetClusterCount() : chunk.particleCount;
+    for (const auto& range : m_pointRanges)
+        totalUnits += range.pointCount;
+
+    uint64_t unitsPerBatch = (totalUnits + batchCount - 1) / batchCount;
+    uint64_t batchBegin = std::min(batch * unitsPerBatch, totalUnits);
+    uint64_t batchEnd = std::min(batchBegin + unitsPerBatch, totalUnits);
+
+    uint64_t rangeBegin = 0;
+    auto drawRange = [&](VkBuffer vertexBuffer, uint64_t unitCount, ClusterSorter* sorter)
+    {
+        uint64_t rangeEnd = rangeBegin + unitCount;
+        uint64_t begin = std::max(batchBegin, rangeBegin);
+        uint64_t end = std::min(batchEnd, rangeEnd);
+
+        if (begin < end)
+        {
+            VkDeviceSize offsets[] = { 0 };
+            vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer, offsets);
+
+            uint32_t first = static_cast<uint32_t>(begin - rangeBegin);
+            uint32_t count = static_cast<uint32_t>(end - begin);
+            if (sorter)
+                sorter->Draw(cmd, first, count);
+            else
+                vkCmdDraw(cmd, count, 1, first, 0);
+        }
+
+        rangeBegin = rangeEnd;
+    };
+
+    for (const auto& chunk : particles.chunks)
+        drawRange(chunk.particles->Get(), chunk.clusterSorter ? chunk.clusterSorter->GetClusterCount() : chunk.particleCount, chunk.clusterSorter.get());
+    for (const auto& range : m_pointRanges)
+        drawRange(range.buffer->Get(), range.pointCount, nullptr);
+}
+
+void Renderer::StartRenderThread()
+{
+    if (m_renderThread.joinable())
+        return;
+
+    m_renderThread = std::thread(&Renderer::RenderThreadMain, this);
+}
+
+void Renderer::Quit()
+{
+    while (!m_commands.Push({ RenderCommand::Type::Quit }))
+        std::this_thread::yield();
+}
+
+void Renderer::RenderThreadMain()
+{
+    while (!m_quit)
+    {
+        // Quit is otherwise only seen once a frame has acquired its image
+        ProcessCommands();
+        Run();
+    }
+}
+
+void Renderer::ProcessCommands()
+{
+    RenderCommand command;
+    while (m_commands.Pop(command))
+    {
+        switch (command.type)
+        {
+        case RenderCommand::Type::CameraDistance:
+            m_cameraDistance = command.value;
+            break;
+        case RenderCommand::Type::Resize:
+            m_windowExtent = { command.width, command.height };
+            m_framebufferResized = true;
+            break;
+        case RenderCommand::Type::Quit:
+            m_quit = true;
+            break;
+        case RenderCommand::Type::PresentPolicy:
+            if (static_cast<PresentPolicy>(command.option) != m_presentPolicy)
+            {
+                m_presentPolicy = static_cast<PresentPolicy>(command.option);
+                m_framebufferResized = true;
+            }
+            break;
+        case RenderCommand::Type::FramePacing:
+            m_framePacer.SetTargetFrameTimeMs(command.value);
+            break;
+        case RenderCommand::Type::FixedStep:
+            m_frameClock.SetFixedStepMs(command.value);
+            break;
+        case RenderCommand::Type::Pause:
+            m_frameClock.SetPaused(command.option != 0);
+            break;
+        }
+    }
 }
 
 void Renderer::Shutdown()
 {
+    if (m_renderThread.joinable())
+    {
+        Quit();
+        m_renderThread.join();
+    }
+
     vkDeviceWaitIdle(m_device->Get());
+    m_retiredSwapchains.clear();
 
-    for (uint32_t i = 0; i < m_imageCount; i++) {
+    for (uint32_t i = 0; i < m_maxFramesInFlight; i++) {
+        m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_SEMAPHORE, m_imageAvailable[i]);
         vkDestroySemaphore(m_device->Get(), m_imageAvailable[i], nullptr);
-        vkDestroySemaphore(m_device->Get(), m_renderFinished[i], nullptr);
-        vkDestroyFence(m_device->Get(), m_inFlightFences[i], nullptr);
     }
+    m_frameScheduler.reset();
+
+    DestroyImageSemaphores();
+    DestroyParticleSets();
+    m_memoryCompactor.reset();
+    m_pointUpdater.reset();
+    m_pointRanges.clear();
+    m_uploadService.reset();
+    m_updateCommandBuffers.reset();
+    m_computeCommandBuffers.reset();
+    m_secondaryCommandBuffers.reset();
+    m_imageCommandBuffers.reset();
+    m_commandBuffers.reset();
 }
 
 void Renderer::RecreateSwapchain()
 {
-    vkDeviceWaitIdle(m_device->Get());
+    // The old swapchain is retired rather than destroyed first, so the driver can reuse its resources
+    std::shared_ptr<Swapchain> oldSwapchain = m_swapChain;
+    m_swapChain = std::make_shared<Swapchain>(m_device.get(), m_windowExtent, oldSwapchain.get(), m_presentPolicy);
+    m_stats.presentMode = m_swapChain->GetPresentMode();
+
+    // The frames in flight render into the framebuffers and offscreen targets replaced below, so they have to complete.
+    // Only the graphics timeline is waited on, compute and transfer work is not drained.
+    m_frameScheduler->WaitIdle();
 
-    m_imagesInFlight.clear();
-    m_imagesInFlight.resize(m_imageCount, VK_NULL_HANDLE);
+    // Presents of the old images are queued ahead of the new swapchain's, but completing a frame does not mean its
+    // present has been processed. The old swapchain is kept until a full round of frames has used the new one.
+    m_retiredSwapchains.emplace_back(m_frameScheduler->GetSubmittedFrame() + m_frameScheduler->GetFramesInFlight(), std::move(oldSwapchain));
 
-    for (uint32_t i = 0; i < m_inFlightFences.size(); ++i)
+    // Pipelines, descriptor sets, command pools and frame sync are independent of the swapchain size.
+    // The render pass is kept too unless the surface format changed.
+    m_holeFiller.reset();
+    if (!m_renderPass->Resize(m_swapChain.get()))
     {
-        if (m_imageAvailable[i] != VK_NULL_HANDLE)
-            vkDestroySemaphore(m_device->Get(), m_imageAvailable[i], nullptr);
-        if (m_renderFinished[i] != VK_NULL_HANDLE)
-            vkDestroySemaphore(m_device->Get(), m_renderFinished[i], nullptr);
-        if (m_inFlightFences[i] != VK_NULL_HANDLE)
-            vkDestroyFence(m_device->Get(), m_inFlightFences[i], nullptr);
+        m_graphicsPipeline.reset();
+        m_renderPass = std::make_shared<RenderPass>(m_device.get(), m_swapChain.get(), GetRenderPassSettings());
+        m_graphicsPipeline = std::make_shared<GraphicsPipeline>(m_renderPass, m_device, m_frameUniforms->GetDescriptorSetLayout());
     }
 
-    m_graphicsPipeline.reset();
-    m_renderPass.reset();
-    m_swapChain.reset();
-    m_commandBuffers.reset();
-    m_descriptorPool.reset();
+    uint32_t previousImageCount = m_imageCount;
+    CreateImageSemaphores();
+
+    if (m_prerecordCommands)
+    {
+        // Recorded commands reference the old framebuffers
+        if (m_imageCount != previousImageCount)
+            CreateFrameSlots();
+        else
+            std::fill(m_recorded.begin(), m_recorded.end(), false);
+    }
+
+    // Tiny targets are drawn without hole filling
+    if (m_splatting && HoleFiller::CanFill(m_renderPass->GetColorTarget()->GetExtent()))
+        m_holeFiller = std::make_shared<HoleFiller>(m_device, m_renderPass, m_fillLevels);
+}
+
+void Renderer::ReleaseRetiredSwapchains()
+{
+    uint64_t completed = m_frameScheduler->GetCompletedFrame();
+    std::erase_if(m_retiredSwapchains, [completed](const auto& retired) { return retired.first <= completed; });
+}
 
-    m_swapChain = std::make_shared<Swapchain>(m_device.get(), m_window.get());
-    m_renderPass = std::make_shared<RenderPass>(m_device.get(), m_swapChain.get());
-    m_descriptorPool = std::make_shared<DescriptorPool>(m_device, m_renderPass, m_swapChain, m_triangleBuffer, m_particleBuffer);
-    m_commandBuffers = m_descriptorPool->GetCommandBuffers();
-    m_computePipeline = std::make_shared<ComputePipeline>(m_descriptorPool, m_device);
-    m_graphicsPipeline = std::make_shared<GraphicsPipeline>(m_renderPass, m_swapChain, m_device);
+void Renderer::CreateFrameSlots()
+{
+    // Prerecorded command buffers bind one slot each for their whole lifetime, so there is a slot per swapchain image
+    uint32_t slotCount = m_prerecordCommands ? m_imageCount : m_maxFramesInFlight;
+
+    m_frameUniforms = std::make_shared<FrameUniforms>(m_device, slotCount);
+    if (m_device->SupportsTimestamps())
+        m_gpuTimer = std::make_shared<GpuTimer>(m_device, slotCount);
+
+    if (m_prerecordCommands)
+    {
+        m_imageCommandBuffers = std::make_shared<CommandBuffers>(m_device.get(), m_device->GetGraphicsFamilyIndex(), m_imageCount, true);
+        m_recorded.assign(m_imageCount, false);
+    }
+}
 
+void Renderer::CreateImageSemaphores()
+{
     m_imageCount = static_cast<uint32_t>(m_swapChain->GetImageViews().size());
-    m_imageAvailable.resize(m_imageCount);
-    m_renderFinished.resize(m_imageCount);
-    m_inFlightFences.resize(m_imageCount);
+    m_imageFrames.assign(m_imageCount, 0);
 
-    VkSemaphoreCreateInfo semInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    // Kept across swapchain recreation since a retired image's present may still wait on one, only ever grown
+    if (m_renderFinished.size() < m_imageCount)
+        m_renderFinished.resize(m_imageCount, VK_NULL_HANDLE);
 
+    VkSemaphoreCreateInfo semInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
     for (uint32_t i = 0; i < m_imageCount; ++i)
     {
-        if (vkCreateSemaphore(m_device->Get(), &semInfo, nullptr, &m_imageAvailable[i]) != VK_SUCCESS)
-            Utils::ThrowFatalError("Failed to create imageAvailable semaphore");
+        if (m_renderFinished[i] != VK_NULL_HANDLE)
+            continue;
+
         if (vkCreateSemaphore(m_device->Get(), &semInfo, nullptr, &m_renderFinished[i]) != VK_SUCCESS)
-            Utils::ThrowFatalError("Failed to create renderFinished semaphore");
-        if (vkCreateFence(m_device->Get(), &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
-            Utils::ThrowFatalError("Failed to create inFlight fence");
+            Utils::ThrowFatalError("Failed to create renderFinished semaphore.");
+        m_device->GetRegistry()->Track(VK_OBJECT_TYPE_SEMAPHORE, m_renderFinished[i]);
+    }
+}
+
+void Renderer::DestroyImageSemaphores()
+{
+    for (auto semaphore : m_renderFinished)
+    {
+        if (semaphore != VK_NULL_HANDLE)
+        {
+            m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_SEMAPHORE, semaphore);
+            vkDestroySemaphore(m_device->Get(), semaphore, nullptr);
+        }
+    }
+
+    m_renderFinished.clear();
+    m_imageFrames.clear();
+}
+
+void Renderer::ClampParticleCount()
+{
+    // Per particle: its position, plus its share of the cluster depth and, when sorted, the indirect draw command
+    VkDeviceSize clusterBytes = sizeof(uint32_t);
+    if ((m_depthTest || m_splatting) && m_frontToBack)
+        clusterBytes += sizeof(VkDrawIndirectCommand);
+    VkDeviceSize setCount = m_asyncCompute ? 2 : 1;
+    VkDeviceSize bytesPerParticle = setCount * (sizeof(glm::vec4) + (clusterBytes + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE);
+
+    MemoryHeapBudget heap = m_device->GetDeviceLocalBudget();
+    VkDeviceSize allowed = static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * m_memoryBudgetShare);
+    VkDeviceSize available = allowed > heap.usage ? allowed - heap.usage : 0;
+
+    VkDeviceSize maxParticles = std::max<VkDeviceSize>(available / bytesPerParticle, WORK_GROUP_SIZE);
+    if (m_particleCount > maxParticles)
+    {
+        m_particleCount = static_cast<uint32_t>(maxParticles);
+        std::cerr << "[Renderer] Particle count limited to " << m_particleCount << " by the device memory budget" << std::endl;
+    }
+}
+
+void Renderer::CreateParticleSets()
+{
+    // Storage buffer bindings are limited to maxStorageBufferRange, so particles are split into chunks
+    uint32_t chunkCapacity = GetParticleChunkCapacity();
+    // A full chunk must fit in one dispatch, checked here rather than when the first frame is recorded
+    ComputePipeline::GetDispatchGrid(m_device.get(), chunkCapacity / WORK_GROUP_SIZE);
+    uint32_t chunkCount = (m_particleCount + chunkCapacity - 1) / chunkCapacity;
+
+    m_particleSets.resize(m_asyncCompute ? 2 : 1);
+    for (auto& set : m_particleSets)
+    {
+        set.chunks.resize(chunkCount);
+        for (uint32_t i = 0; i < chunkCount; ++i)
+        {
+            ParticleChunk& chunk = set.chunks[i];
+            chunk.firstParticle = i * chunkCapacity;
+            chunk.particleCount = std::min(chunkCapacity, m_particleCount - chunk.firstParticle);
+
+            // One nearest depth per compute workgroup, written every frame by the particle shader
+            uint32_t clusterCount = (chunk.particleCount + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE;
+
+            chunk.particles = std::make_shared<Buffer>(
+                m_device.get(),
+                sizeof(glm::vec4) * chunk.particleCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                std::vector<uint32_t>{},
+                std::source_location::current()
+            );
+
+            chunk.clusterDepths = std::make_shared<Buffer>(
+                m_device.get(),
+                sizeof(uint32_t) * clusterCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                std::vector<uint32_t>{},
+                std::source_location::current()
+            );
+
+            chunk.descriptorPool = std::make_shared<DescriptorPool>(m_device, m_triangleBuffer, chunk.particles, chunk.clusterDepths);
+
+            if ((m_depthTest || m_splatting) && m_frontToBack)
+                chunk.clusterSorter = std::make_shared<ClusterSorter>(m_device, chunk.clusterDepths, chunk.particleCount, WORK_GROUP_SIZE);
+        }
+
+        if (m_asyncCompute)
+        {
+            VkSemaphoreCreateInfo semInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+            if (vkCreateSemaphore(m_device->Get(), &semInfo, nullptr, &set.generated) != VK_SUCCESS)
+                Utils::ThrowFatalError("Failed to create particlesGenerated semaphore.");
+            m_device->GetRegistry()->Track(VK_OBJECT_TYPE_SEMAPHORE, set.generated);
+        }
     }
+}
+
+void Renderer::UpdatePoints(uint32_t firstPoint, std::span<const float> points)
+{
+    if (!m_pointUpdater)
+        throw std::runtime_error("Only dynamic points can be updated!");
+
+    uint64_t pointCount = points.size() / 4;
+    const PointRange& lastRange = m_pointRanges.back();
+    if (firstPoint + pointCount > static_cast<uint64_t>(lastRange.firstPoint) + lastRange.pointCount)
+        throw std::runtime_error("Point update out of range!");
+
+    // The points may continue across range buffers
+    auto range = std::upper_bound(m_pointRanges.begin(), m_pointRanges.end(), firstPoint,
+        [](uint32_t point, const PointRange& range) { return point < range.firstPoint; }) - 1;
 
-    m_imagesInFlight.resize(m_imageCount, VK_NULL_HANDLE);
+    std::lock_guard<std::mutex> lock(m_pointMutex);
+
+    uint64_t written = 0;
+    while (written < pointCount)
+    {
+        uint32_t point = firstPoint + static_cast<uint32_t>(written);
+        uint64_t count = std::min<uint64_t>(pointCount - written, range->firstPoint + range->pointCount - point);
+
+        std::span<const float> values = points.subspan(static_cast<size_t>(written * 4), static_cast<size_t>(count * 4));
+        m_pointUpdater->Write(range->buffer, sizeof(glm::vec4) * (point - range->firstPoint), std::as_bytes(values));
+
+        written += count;
+        ++range;
+    }
+}
+
+void Renderer::UpdatePoints(std::span<const uint32_t> indices, std::span<const float> points)
+{
+    if (points.size() != indices.size() * 4)
+        throw std::runtime_error("Point update needs four floats per index!");
+
+    // Runs of consecutive indices are written as one range, the updater merges whatever touches across runs
+    size_t runBegin = 0;
+    for (size_t i = 1; i <= indices.size(); ++i)
+    {
+        if (i < indices.size() && indices[i] == indices[i - 1] + 1)
+            continue;
+
+        UpdatePoints(indices[runBegin], points.subspan(runBegin * 4, (i - runBegin) * 4));
+        runBegin = i;
+    }
+}
+
+void Renderer::SetViewCamera(uint32_t index, const glm::vec3& eye, const glm::vec3& target)
+{
+    if (index >= MAX_VIEWS)
+        throw std::runtime_error("View camera index is out of range!");
+
+    std::lock_guard<std::mutex> lock(m_viewMutex);
+    m_viewCameras[index] = { eye, target, true };
+}
+
+void Renderer::ResetViewCamera(uint32_t index)
+{
+    if (index >= MAX_VIEWS)
+        throw std::runtime_error("View camera index is out of range!");
+
+    std::lock_guard<std::mutex> lock(m_viewMutex);
+    m_viewCameras[index].placed = false;
+}
+
+UploadTicket Renderer::CreatePointBuffers()
+{
+    const std::byte* data = reinterpret_cast<const std::byte*>(m_points.data());
+    VkDeviceSize size = m_points.size_bytes();
+    VkDeviceSize placed = 0;
+    UploadTicket ticket{};
+
+    // Each buffer gets its own allocation, 1 GiB is the smallest maxMemoryAllocationSize a device may report
+    const VkDeviceSize maxRangeBytes = 1ull << 30;
+
+    // Imported memory has to start and end on the driver's alignment, whole points keep the ranges drawable.
+    // Dynamic points are updated by copies into their buffers, which must not write the application's memory.
+    if (m_device->SupportsHostMemoryImport() && !m_dynamicPoints)
+    {
+        VkDeviceSize alignment = std::max<VkDeviceSize>(m_device->GetHostPointerAlignment(), sizeof(glm::vec4));
+        if (reinterpret_cast<uintptr_t>(data) % alignment == 0)
+        {
+            while (size - placed >= alignment)
+            {
+                VkDeviceSize rangeBytes = std::min(size - placed, maxRangeBytes) & ~(alignment - 1);
+                try
+                {
+                    auto buffer = std::make_shared<Buffer>(m_device.get(), data + placed, rangeBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                        std::vector<uint32_t>{}, std::source_location::current());
+                    m_pointRanges.push_back({ buffer, static_cast<uint32_t>(placed / sizeof(glm::vec4)), static_cast<uint32_t>(rangeBytes / sizeof(glm::vec4)) });
+                }
+                catch (const std::runtime_error&)
+                {
+                    std::cerr << "[Renderer] Points could not be imported from host memory, the rest is copied" << std::endl;
+                    break;
+                }
+                placed += rangeBytes;
+            }
+        }
+    }
+
+    // Whatever was not imported, an unaligned tail or everything without the extension, is staged into device-local memory
+    while (placed < size)
+    {
+        VkDeviceSize rangeBytes = std::min(size - placed, maxRangeBytes);
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | (m_dynamicPoints ? VK_BUFFER_USAGE_TRANSFER_DST_BIT : 0);
+        // Compaction copies the points when it moves them
+        if (m_memoryCompaction)
+            usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        auto buffer = m_uploadService->CreateBuffer(data + placed, rangeBytes, usage, { m_device->GetGraphicsFamilyIndex() }, ticket);
+        m_pointRanges.push_back({ buffer, static_cast<uint32_t>(placed / sizeof(glm::vec4)), static_cast<uint32_t>(rangeBytes / sizeof(glm::vec4)) });
+        placed += rangeBytes;
+    }
+
+    // Uploads complete in order, so the last one's ticket covers them all
+    return ticket;
+}
+
+void Renderer::RegisterCompaction()
+{
+    m_memoryCompactor = std::make_shared<MemoryCompactor>(m_compactionBytesPerFrame);
+
+    // Imported ranges are the application's memory and are never moved
+    for (size_t i = 0; i < m_pointRanges.size(); ++i)
+    {
+        m_memoryCompactor->Register(m_pointRanges[i].buffer, [this, i](const std::shared_ptr<Buffer>& buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_pointMutex);
+
+            // Writes made since the frame's updates were recorded land in the new buffer
+            if (m_pointUpdater)
+                m_pointUpdater->Retarget(m_pointRanges[i].buffer, buffer);
+            m_pointRanges[i].buffer = buffer;
+            std::fill(m_recorded.begin(), m_recorded.end(), false);
+        });
+    }
+
+    // Particles are regenerated every frame before they are drawn, so they move without a copy. Descriptor sets in use
+    // by frames in flight cannot be updated, the chunk gets new ones and the old ones are retired with the buffer.
+    // Async compute writes particle sets on another queue while frames are recorded, so they stay where they are.
+    if (m_asyncCompute)
+        return;
+
+    for (size_t s = 0; s < m_particleSets.size(); ++s)
+    {
+        for (size_t c = 0; c < m_particleSets[s].chunks.size(); ++c)
+        {
+            m_memoryCompactor->Register(m_particleSets[s].chunks[c].particles, [this, s, c](const std::shared_ptr<Buffer>& buffer)
+            {
+                ParticleChunk& chunk = m_particleSets[s].chunks[c];
+                m_memoryCompactor->Retire(chunk.descriptorPool);
+
+                chunk.particles = buffer;
+                chunk.descriptorPool = std::make_shared<DescriptorPool>(m_device, m_triangleBuffer, chunk.particles, chunk.clusterDepths);
+                std::fill(m_recorded.begin(), m_recorded.end(), false);
+            }, false);
+        }
+    }
+}
+
+void Renderer::DestroyParticleSets()
+{
+    for (auto& set : m_particleSets)
+    {
+        if (set.generated != VK_NULL_HANDLE)
+        {
+            m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_SEMAPHORE, set.generated);
+            vkDestroySemaphore(m_device->Get(), set.generated, nullptr);
+        }
+    }
+
+    m_particleSets.clear();
+}
+
+void Renderer::UpdateFrameTiming(uint32_t slot)
+{
+    // The frame that last used this slot has completed, so its timestamps are ready
+    float gpuFrameTimeMs = 0.0f;
+    if (m_gpuTimer && m_gpuTimer->GetElapsedMs(slot, gpuFrameTimeMs))
+    {
+        m_stats.gpuFrameTimeMs = gpuFrameTimeMs;
+        if (m_dynamicResolution)
+            m_resolutionScaler.Update(gpuFrameTimeMs);
+    }
+
+    if (m_dynamicResolution)
+        m_renderPass->SetRenderExtent(m_resolutionScaler.GetRenderExtent(m_renderPass->GetTargetExtent()));
+
+    // Sampled on the first frame, then once per interval
+    if ((m_frameClock.GetFrameIndex() - 1) % MEMORY_STATS_INTERVAL == 0)
+    {
+        m_stats.memory = m_device->GetAllocator()->GetStats();
+        m_stats.deviceMemory = m_device->GetDeviceLocalBudget();
+        m_stats.liveObjects = m_device->GetRegistry()->GetLiveCount();
+    }
+
+    m_stats.cpuFrameTimeMs = m_frameClock.GetRealDeltaMs();
+    m_stats.animationTime = static_cast<float>(m_frameClock.GetTime());
+    m_stats.frameIndex = m_frameClock.GetFrameIndex();
+
+    m_stats.renderExtent = m_renderPass->GetRenderExtent();
+    m_stats.renderScale = static_cast<float>(m_stats.renderExtent.width) / static_cast<float>(m_renderPass->GetTargetExtent().width);
+}
+
+RenderPassSettings Renderer::GetRenderPassSettings() const
+{
+    RenderPassSettings settings{};
+    settings.offscreen = m_dynamicResolution;
+    settings.depth = m_depthTest;
+    settings.splatting = m_splatting;
+    settings.viewCount = m_viewCount;
+    return settings;
 }
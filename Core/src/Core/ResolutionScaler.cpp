@@ -0,0 +1,48 @@
+#include "ResolutionScaler.h"
+
+// STD
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Ignore measurements within this fraction of the budget to avoid oscillating around it
+	constexpr float DEADBAND = 0.05f;
+
+	// Fraction of the computed correction applied per adjustment
+	constexpr float DAMPING = 0.5f;
+}
+
+ResolutionScaler::ResolutionScaler(float targetFrameTimeMs, float minScale, float maxScale, uint32_t adjustInterval)
+	: m_targetFrameTimeMs(targetFrameTimeMs), m_minScale(minScale), m_maxScale(maxScale), m_adjustInterval(std::max(adjustInterval, 1u)), m_scale(maxScale)
+{
+}
+
+void ResolutionScaler::Update(float gpuFrameTimeMs)
+{
+	m_accumulatedMs += gpuFrameTimeMs;
+	if (++m_sampleCount < m_adjustInterval)
+		return;
+
+	float averageMs = m_accumulatedMs / static_cast<float>(m_sampleCount);
+	m_accumulatedMs = 0.0f;
+	m_sampleCount = 0;
+
+	if (averageMs <= 0.0f)
+		return;
+
+	float ratio = m_targetFrameTimeMs / averageMs;
+	if (std::abs(1.0f - ratio) < DEADBAND)
+		return;
+
+	float target = m_scale * std::sqrt(ratio);
+	m_scale = std::clamp(m_scale + (target - m_scale) * DAMPING, m_minScale, m_maxScale);
+}
+
+VkExtent2D ResolutionScaler::GetRenderExtent(VkExtent2D outputExtent) const
+{
+	VkExtent2D extent{};
+	extent.width = std::max(1u, static_cast<uint32_t>(outputExtent.width * m_scale));
+	extent.height = std::max(1u, static_cast<uint32_t>(outputExtent.height * m_scale));
+	return extent;
+}
@@ -0,0 +1,85 @@
+#include "ResourceRegistry.h"
+
+// STD
+#include <iostream>
+
+void ResourceRegistry::TrackKey(VkObjectType type, uint64_t handle, VkDeviceSize size, const std::source_location& site)
+{
+    if (handle == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_objects[{ type, handle }] = { size, site.file_name(), site.line() };
+}
+
+void ResourceRegistry::UntrackKey(VkObjectType type, uint64_t handle)
+{
+    if (handle == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_objects.erase({ type, handle }) == 0)
+        std::cerr << "[ResourceRegistry] Destroyed untracked " << GetTypeName(type) << " 0x" << std::hex << handle << std::dec << std::endl;
+}
+
+std::vector<ResourceTypeStats> ResourceRegistry::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Entries are ordered by type, so each type's objects are adjacent
+    std::vector<ResourceTypeStats> stats;
+    for (const auto& [key, entry] : m_objects)
+    {
+        if (stats.empty() || stats.back().type != key.first)
+            stats.push_back({ key.first, 0, 0 });
+
+        stats.back().count++;
+        stats.back().bytes += entry.size;
+    }
+    return stats;
+}
+
+uint32_t ResourceRegistry::GetLiveCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<uint32_t>(m_objects.size());
+}
+
+uint32_t ResourceRegistry::ReportLeaks() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const auto& [key, entry] : m_objects)
+    {
+        std::cerr << "[ResourceRegistry] Leaked " << GetTypeName(key.first) << " 0x" << std::hex << key.second << std::dec;
+        if (entry.size > 0)
+            std::cerr << " (" << entry.size << " bytes)";
+        std::cerr << " created at " << entry.file << ":" << entry.line << std::endl;
+    }
+    return static_cast<uint32_t>(m_objects.size());
+}
+
+const char* ResourceRegistry::GetTypeName(VkObjectType type)
+{
+    switch (type)
+    {
+    case VK_OBJECT_TYPE_SEMAPHORE:              return "VkSemaphore";
+    case VK_OBJECT_TYPE_FENCE:                  return "VkFence";
+    case VK_OBJECT_TYPE_DEVICE_MEMORY:          return "VkDeviceMemory";
+    case VK_OBJECT_TYPE_BUFFER:                 return "VkBuffer";
+    case VK_OBJECT_TYPE_IMAGE:                  return "VkImage";
+    case VK_OBJECT_TYPE_QUERY_POOL:             return "VkQueryPool";
+    case VK_OBJECT_TYPE_IMAGE_VIEW:             return "VkImageView";
+    case VK_OBJECT_TYPE_SHADER_MODULE:          return "VkShaderModule";
+    case VK_OBJECT_TYPE_PIPELINE_LAYOUT:        return "VkPipelineLayout";
+    case VK_OBJECT_TYPE_RENDER_PASS:            return "VkRenderPass";
+    case VK_OBJECT_TYPE_PIPELINE:               return "VkPipeline";
+    case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:  return "VkDescriptorSetLayout";
+    case VK_OBJECT_TYPE_SAMPLER:                return "VkSampler";
+    case VK_OBJECT_TYPE_DESCRIPTOR_POOL:        return "VkDescriptorPool";
+    case VK_OBJECT_TYPE_FRAMEBUFFER:            return "VkFramebuffer";
+    case VK_OBJECT_TYPE_COMMAND_POOL:           return "VkCommandPool";
+    case VK_OBJECT_TYPE_SWAPCHAIN_KHR:          return "VkSwapchainKHR";
+    default:                                    return "VkObject";
+    }
+}
@@ -0,0 +1,99 @@
+#include "SecondaryCommandBuffers.h"
+
+// STD
+#include <stdexcept>
+
+SecondaryCommandBuffers::SecondaryCommandBuffers(Device* device, uint32_t queueFamilyIndex, uint32_t frameCount)
+	: m_device(device->Get()), m_registry(device->GetRegistry()), m_queueFamilyIndex(queueFamilyIndex), m_frameCount(frameCount)
+{
+}
+
+SecondaryCommandBuffers::~SecondaryCommandBuffers()
+{
+    for (auto& [thread, pools] : m_pools)
+    {
+        for (auto& pool : pools)
+        {
+            if (pool.pool != VK_NULL_HANDLE)
+            {
+                m_registry->Untrack(VK_OBJECT_TYPE_COMMAND_POOL, pool.pool);
+                vkDestroyCommandPool(m_device, pool.pool, nullptr);
+            }
+        }
+    }
+}
+
+void SecondaryCommandBuffers::Reset(uint32_t frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& [thread, pools] : m_pools)
+    {
+        Pool& pool = pools[frame];
+        if (pool.used == 0)
+            continue;
+
+        if (vkResetCommandPool(m_device, pool.pool, 0) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to reset secondary command pool!");
+        }
+        pool.used = 0;
+    }
+}
+
+SecondaryCommandBuffers::Pool& SecondaryCommandBuffers::GetThreadPool(uint32_t frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Map nodes stay in place when other threads add theirs, so the pool can be used after the lock is released
+    auto [it, inserted] = m_pools.try_emplace(std::this_thread::get_id());
+    if (inserted)
+    {
+        it->second.resize(m_frameCount);
+        for (auto& pool : it->second)
+        {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = m_queueFamilyIndex;
+
+            if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create secondary command pool!");
+            }
+            m_registry->Track(VK_OBJECT_TYPE_COMMAND_POOL, pool.pool);
+        }
+    }
+
+    return it->second[frame];
+}
+
+VkCommandBuffer SecondaryCommandBuffers::Begin(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance)
+{
+    Pool& pool = GetThreadPool(frame);
+
+    if (pool.used == pool.buffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(m_device, &allocInfo, &buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate secondary command buffer!");
+        }
+        pool.buffers.push_back(buffer);
+    }
+
+    VkCommandBuffer cmd = pool.buffers[pool.used++];
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+
+    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin secondary command buffer!");
+    }
+
+    return cmd;
+}
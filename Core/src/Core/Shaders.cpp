@@ -0,0 +1,78 @@
+#include "Shaders.h"
+
+// PCR
+#include "Utils.h"
+
+namespace
+{
+    // Generated by the shader build step in Build-Core.lua
+    constexpr uint32_t pointcloud_comp[] =
+    {
+        #include "pointcloud_comp.inc"
+    };
+
+    constexpr uint32_t pointcloud_vert[] =
+    {
+        #include "pointcloud_vert.inc"
+    };
+
+    constexpr uint32_t pointcloud_frag[] =
+    {
+        #include "pointcloud_frag.inc"
+    };
+
+    constexpr uint32_t pointcloud_order_comp[] =
+    {
+        #include "pointcloud_order_comp.inc"
+    };
+
+    constexpr uint32_t pointcloud_splat_frag[] =
+    {
+        #include "pointcloud_splat_frag.inc"
+    };
+
+    constexpr uint32_t pointcloud_fill_comp[] =
+    {
+        #include "pointcloud_fill_comp.inc"
+    };
+
+    constexpr uint32_t pointcloud_multiview_vert[] =
+    {
+        #include "pointcloud_multiview_vert.inc"
+    };
+
+    std::string s_overrideDirectory;
+}
+
+namespace Shaders
+{
+    const ShaderSource PointCloudComp{ "pointcloud.comp.spv", pointcloud_comp };
+    const ShaderSource PointCloudVert{ "pointcloud.vert.spv", pointcloud_vert };
+    const ShaderSource PointCloudFrag{ "pointcloud.frag.spv", pointcloud_frag };
+    const ShaderSource PointCloudOrder{ "pointcloud_order.comp.spv", pointcloud_order_comp };
+    const ShaderSource PointCloudSplatFrag{ "pointcloud_splat.frag.spv", pointcloud_splat_frag };
+    const ShaderSource PointCloudFill{ "pointcloud_fill.comp.spv", pointcloud_fill_comp };
+    const ShaderSource PointCloudMultiviewVert{ "pointcloud_multiview.vert.spv", pointcloud_multiview_vert };
+
+    void SetOverrideDirectory(const std::string& directory)
+    {
+        s_overrideDirectory = directory;
+    }
+
+    const std::string& GetOverrideDirectory()
+    {
+        return s_overrideDirectory;
+    }
+
+    VkShaderModule CreateModule(VkDevice device, const ShaderSource& shader)
+    {
+        if (!s_overrideDirectory.empty())
+        {
+            // SPIR-V is a whole number of words and the vector's storage is suitably aligned for them
+            auto code = Utils::ReadFile(s_overrideDirectory + "/" + shader.name);
+            return Utils::CreateShaderModule(device, { reinterpret_cast<const uint32_t*>(code.data()), code.size() / sizeof(uint32_t) });
+        }
+
+        return Utils::CreateShaderModule(device, shader.code);
+    }
+}
@@ -6,15 +6,15 @@
 // STD
 #include <algorithm>
 
-Swapchain::Swapchain(Device* device, Window* window)
-	: m_physicalDevice(device->GetPhysicalDevice()), m_device(device->Get()), m_surface(device->GetSurface())
+Swapchain::Swapchain(Device* device, VkExtent2D windowExtent, Swapchain* oldSwapchain, PresentPolicy policy)
+	: m_physicalDevice(device->GetPhysicalDevice()), m_device(device->Get()), m_registry(device->GetRegistry()), m_surface(device->GetSurface()), m_policy(policy)
 {
-	uint32_t width = window->GetWidth();
-	uint32_t height = window->GetHeight();
+	uint32_t width = windowExtent.width;
+	uint32_t height = windowExtent.height;
 	uint32_t graphicsFamily = device->GetGraphicsFamilyIndex();
 	uint32_t presentFamily = device->GetPresentFamilyIndex();
 
-	CreateSwapchain(width, height, graphicsFamily, presentFamily);
+	CreateSwapchain(width, height, graphicsFamily, presentFamily, oldSwapchain ? oldSwapchain->Get() : VK_NULL_HANDLE);
 	CreateImageViews();
 }
 
@@ -22,11 +22,13 @@ Swapchain::~Swapchain()
 {
 	for (auto view : m_imageViews) 
     {
+		m_registry->Untrack(VK_OBJECT_TYPE_IMAGE_VIEW, view);
 		vkDestroyImageView(m_device, view, nullptr);
 	}
 
 	if (m_swapchain != VK_NULL_HANDLE) 
     {
+		m_registry->Untrack(VK_OBJECT_TYPE_SWAPCHAIN_KHR, m_swapchain);
 		vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
 	}
 }
@@ -71,16 +73,41 @@ VkSurfaceFormatKHR Swapchain::ChooseSurfaceFormat(const std::vector<VkSurfaceFor
     return availableFormats[0];
 }
 
-VkPresentModeKHR Swapchain::ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes)
+VkPresentModeKHR Swapchain::ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes) const
 {
-    for (const auto& mode : availableModes) 
+    auto isAvailable = [&](VkPresentModeKHR mode)
     {
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) return mode;
+        return std::find(availableModes.begin(), availableModes.end(), mode) != availableModes.end();
+    };
+
+    // FIFO is the only mode every implementation supports
+    switch (m_policy)
+    {
+    case PresentPolicy::Throughput:
+        if (isAvailable(VK_PRESENT_MODE_IMMEDIATE_KHR)) return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        if (isAvailable(VK_PRESENT_MODE_MAILBOX_KHR)) return VK_PRESENT_MODE_MAILBOX_KHR;
+        break;
+    case PresentPolicy::LowLatency:
+        if (isAvailable(VK_PRESENT_MODE_MAILBOX_KHR)) return VK_PRESENT_MODE_MAILBOX_KHR;
+        break;
+    case PresentPolicy::PowerSaving:
+        break;
     }
 
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+uint32_t Swapchain::ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities) const
+{
+    // Power saving queues as few frames as possible, the other policies keep one spare image so rendering never waits on the display
+    uint32_t imageCount = capabilities.minImageCount + (m_policy == PresentPolicy::PowerSaving ? 0 : 1);
+    if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
+        imageCount = capabilities.maxImageCount;
+    }
+
+    return imageCount;
+}
+
 VkExtent2D Swapchain::ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t width, uint32_t height)
 {
     if (capabilities.currentExtent.width != UINT32_MAX) 
@@ -97,7 +124,7 @@ VkExtent2D Swapchain::ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities,
     }
 }
 
-void Swapchain::CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphicsFamily, uint32_t presentFamily)
+void Swapchain::CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphicsFamily, uint32_t presentFamily, VkSwapchainKHR oldSwapchain)
 {
     SwapchainSupportDetails support = QuerySwapchainSupport(m_physicalDevice);
 
@@ -105,10 +132,7 @@ void Swapchain::CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphi
     VkPresentModeKHR presentMode = ChoosePresentMode(support.presentModes);
     VkExtent2D extent = ChooseExtent(support.capabilities, width, height);
 
-    uint32_t imageCount = support.capabilities.minImageCount + 1;
-    if (support.capabilities.maxImageCount > 0 && imageCount > support.capabilities.maxImageCount) {
-        imageCount = support.capabilities.maxImageCount;
-    }
+    uint32_t imageCount = ChooseImageCount(support.capabilities);
 
     VkSwapchainCreateInfoKHR createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -118,7 +142,8 @@ void Swapchain::CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphi
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // Transfer destination is requested where supported so offscreen targets can be blitted into the swapchain
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
 
     uint32_t queueFamilyIndices[] = { graphicsFamily, presentFamily };
     if (graphicsFamily != presentFamily) {
@@ -134,12 +159,13 @@ void Swapchain::CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphi
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = oldSwapchain;
 
     if (vkCreateSwapchainKHR(m_device, &createInfo, nullptr, &m_swapchain) != VK_SUCCESS) 
     {
         Utils::ThrowFatalError("Failed to create swapchain!");
     }
+    m_registry->Track(VK_OBJECT_TYPE_SWAPCHAIN_KHR, m_swapchain);
 
     vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, nullptr);
     m_images.resize(imageCount);
@@ -147,6 +173,8 @@ void Swapchain::CreateSwapchain(uint32_t width, uint32_t height, uint32_t graphi
 
     m_format = surfaceFormat.format;
     m_extent = extent;
+    m_usage = createInfo.imageUsage;
+    m_presentMode = presentMode;
 }
 
 void Swapchain::CreateImageViews()
@@ -173,5 +201,6 @@ void Swapchain::CreateImageViews()
         {
             Utils::ThrowFatalError("Failed to create image views!");
         }
+        m_registry->Track(VK_OBJECT_TYPE_IMAGE_VIEW, m_imageViews[i]);
     }
 }
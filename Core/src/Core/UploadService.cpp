@@ -0,0 +1,259 @@
+#include "UploadService.h"
+
+// STD
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Keeps every staging range aligned for any copy, including the optimal buffer copy offset
+    constexpr VkDeviceSize STAGING_ALIGNMENT = 256;
+}
+
+UploadService::UploadService(std::shared_ptr<Device> device, VkDeviceSize stagingSize)
+	: m_device(device)
+{
+    m_staging = std::make_shared<Buffer>(
+        m_device.get(),
+        stagingSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        std::vector<uint32_t>{},
+        std::source_location::current()
+    );
+    m_stagingData = m_staging->GetMapped<uint8_t>().data();
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = m_device->GetTransferFamilyIndex();
+
+    if (vkCreateCommandPool(m_device->Get(), &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upload command pool!");
+    }
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_COMMAND_POOL, m_commandPool);
+}
+
+UploadService::~UploadService()
+{
+    WaitIdle();
+
+    for (auto& submission : m_free)
+    {
+        m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_FENCE, submission.fence);
+        vkDestroyFence(m_device->Get(), submission.fence, nullptr);
+    }
+
+    // Destroying the pool frees its command buffers
+    m_device->GetRegistry()->Untrack(VK_OBJECT_TYPE_COMMAND_POOL, m_commandPool);
+    vkDestroyCommandPool(m_device->Get(), m_commandPool, nullptr);
+}
+
+std::shared_ptr<Buffer> UploadService::CreateBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage,
+    const std::vector<uint32_t>& queueFamilies, UploadTicket& ticket, std::source_location site)
+{
+    if (HasHostVisibleDeviceMemory())
+    {
+        // Written in place, the data is visible to the device as soon as it is submitted
+        auto buffer = std::make_shared<Buffer>(
+            m_device.get(),
+            size,
+            usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            queueFamilies,
+            site
+        );
+        buffer->CopyData(data, size);
+        ticket = {};
+        return buffer;
+    }
+
+    std::vector<uint32_t> families = queueFamilies;
+    families.push_back(m_device->GetTransferFamilyIndex());
+
+    auto buffer = std::make_shared<Buffer>(
+        m_device.get(),
+        size,
+        usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        families,
+        site
+    );
+    ticket = Upload(*buffer, data, size);
+    return buffer;
+}
+
+UploadTicket UploadService::Upload(Buffer& dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+{
+    VkDeviceSize capacity = m_staging->GetSize();
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+
+    UploadTicket ticket{};
+    for (VkDeviceSize copied = 0; copied < size; )
+    {
+        VkDeviceSize chunk = std::min(size - copied, capacity);
+        VkDeviceSize stagingOffset = ReserveStaging(chunk);
+        memcpy(m_stagingData + stagingOffset, src + copied, static_cast<size_t>(chunk));
+        m_staging->Flush(stagingOffset, chunk);
+
+        Submission submission = AcquireSubmission();
+        submission.begin = stagingOffset;
+        submission.end = stagingOffset + chunk;
+        submission.id = m_nextId++;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(submission.cmd, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin upload command buffer!");
+        }
+
+        VkBufferCopy region{};
+        region.srcOffset = stagingOffset;
+        region.dstOffset = dstOffset + copied;
+        region.size = chunk;
+        vkCmdCopyBuffer(submission.cmd, m_staging->Get(), dst.Get(), 1, &region);
+
+        if (vkEndCommandBuffer(submission.cmd) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record upload command buffer!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &submission.cmd;
+
+        if (vkQueueSubmit(m_device->GetTransferQueue(), 1, &submitInfo, submission.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit upload!");
+        }
+
+        m_pending.push_back(submission);
+        ticket.id = submission.id;
+        copied += chunk;
+    }
+
+    return ticket;
+}
+
+bool UploadService::HasHostVisibleDeviceMemory() const
+{
+    if (!m_device->HasUnifiedMemory())
+        return false;
+
+    VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkPhysicalDeviceMemoryProperties& memoryProperties = m_device->GetAllocator()->GetMemoryProperties();
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((memoryProperties.memoryTypes[i].propertyFlags & wanted) == wanted)
+            return true;
+    }
+    return false;
+}
+
+bool UploadService::IsComplete(UploadTicket ticket)
+{
+    RetireCompleted();
+    return ticket.id <= m_completedId;
+}
+
+void UploadService::Wait(UploadTicket ticket)
+{
+    while (!m_pending.empty() && m_completedId < ticket.id)
+        RetireOldest();
+}
+
+void UploadService::WaitIdle()
+{
+    while (!m_pending.empty())
+        RetireOldest();
+}
+
+VkDeviceSize UploadService::ReserveStaging(VkDeviceSize size)
+{
+    VkDeviceSize capacity = m_staging->GetSize();
+    VkDeviceSize alignedSize = std::min((size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1), capacity);
+
+    RetireCompleted();
+    while (true)
+    {
+        if (m_pending.empty())
+            m_stagingHead = 0;
+
+        // Copies still in flight occupy the ring from the oldest one's start up to the head. Once the newest
+        // starts below the oldest the head has wrapped and only the gap before the oldest is free.
+        VkDeviceSize tail = m_pending.empty() ? capacity : m_pending.front().begin;
+        bool wrapped = !m_pending.empty() && m_pending.back().begin < tail;
+
+        if (!wrapped && m_stagingHead + alignedSize <= capacity)
+            break;
+        if (!wrapped && !m_pending.empty() && alignedSize <= tail)
+        {
+            m_stagingHead = 0;
+            break;
+        }
+        if (wrapped && m_stagingHead + alignedSize <= tail)
+            break;
+
+        RetireOldest();
+    }
+
+    VkDeviceSize offset = m_stagingHead;
+    m_stagingHead += alignedSize;
+    return offset;
+}
+
+void UploadService::RetireOldest()
+{
+    Submission submission = m_pending.front();
+
+    // Left pending on failure, its staging range may still be read by the transfer
+    if (vkWaitForFences(m_device->Get(), 1, &submission.fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+        throw std::runtime_error("Failed to wait for upload submission!");
+
+    m_pending.pop_front();
+    m_completedId = submission.id;
+    m_free.push_back(submission);
+}
+
+void UploadService::RetireCompleted()
+{
+    while (!m_pending.empty() && vkGetFenceStatus(m_device->Get(), m_pending.front().fence) == VK_SUCCESS)
+        RetireOldest();
+}
+
+UploadService::Submission UploadService::AcquireSubmission()
+{
+    if (!m_free.empty())
+    {
+        Submission submission = m_free.back();
+        m_free.pop_back();
+
+        vkResetFences(m_device->Get(), 1, &submission.fence);
+        vkResetCommandBuffer(submission.cmd, 0);
+        return submission;
+    }
+
+    Submission submission{};
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(m_device->Get(), &allocInfo, &submission.cmd) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate upload command buffer!");
+    }
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(m_device->Get(), &fenceInfo, nullptr, &submission.fence) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upload fence!");
+    }
+    m_device->GetRegistry()->Track(VK_OBJECT_TYPE_FENCE, submission.fence);
+
+    return submission;
+}
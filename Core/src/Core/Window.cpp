@@ -27,6 +27,13 @@ Window::Window(const std::string& title, int width, int height)
 	{
 		Utils::ThrowFatalError("Failed to create SDL window");
 	}
+
+	// The drawable can be larger than the requested size on high-DPI displays
+	int drawableWidth = 0;
+	int drawableHeight = 0;
+	SDL_Vulkan_GetDrawableSize(m_window, &drawableWidth, &drawableHeight);
+	m_width = static_cast<uint32_t>(drawableWidth);
+	m_height = static_cast<uint32_t>(drawableHeight);
 }
 
 Window::~Window()
@@ -39,28 +46,62 @@ Window::~Window()
 	SDL_Quit();
 }
 
+int Window::GetRefreshRate() const
+{
+	SDL_DisplayMode mode;
+	if (SDL_GetWindowDisplayMode(m_window, &mode) != 0 || mode.refresh_rate <= 0)
+	{
+		return 60;
+	}
+	return mode.refresh_rate;
+}
+
 bool Window::PollEvents()
 {
 	SDL_Event event;
 	while (SDL_PollEvent(&event)) 
 	{
-		if (event.type == SDL_QUIT) 
+		if (!HandleEvent(event))
 		{
 			return false;
 		}
+	}
+	return true;
+}
 
-		if (event.type == SDL_WINDOWEVENT &&
-			event.window.event == SDL_WINDOWEVENT_RESIZED)
-		{
-			FramebufferResized = true;
-		}
+bool Window::WaitEvents(int timeoutMs)
+{
+	SDL_Event event;
+	if (SDL_WaitEventTimeout(&event, timeoutMs) && !HandleEvent(event))
+	{
+		return false;
+	}
+	return PollEvents();
+}
 
-		if (event.type == SDL_MOUSEWHEEL)
-		{
-			CameraDistance -= event.wheel.y * ZoomSpeed;
-			if (CameraDistance < 0.1f) CameraDistance = 0.1f;
-			if (CameraDistance > 20.0f) CameraDistance = 20.0f;
-		}
+bool Window::HandleEvent(const SDL_Event& event)
+{
+	if (event.type == SDL_QUIT) 
+	{
+		return false;
+	}
+
+	if (event.type == SDL_WINDOWEVENT &&
+		event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+	{
+		int width = 0;
+		int height = 0;
+		SDL_Vulkan_GetDrawableSize(m_window, &width, &height);
+		m_width = static_cast<uint32_t>(width);
+		m_height = static_cast<uint32_t>(height);
+		FramebufferResized = true;
+	}
+
+	if (event.type == SDL_MOUSEWHEEL)
+	{
+		CameraDistance -= event.wheel.y * ZoomSpeed;
+		if (CameraDistance < 0.1f) CameraDistance = 0.1f;
+		if (CameraDistance > 20.0f) CameraDistance = 20.0f;
 	}
 	return true;
 }
\ No newline at end of file
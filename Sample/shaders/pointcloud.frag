@@ -1,4 +1,8 @@
 #version 450
+
+// Depth is never written here, so depth testing can always happen before shading
+layout(early_fragment_tests) in;
+
 layout(location = 0) out vec4 outColor;
 
 void main() {
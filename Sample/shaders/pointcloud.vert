@@ -1,11 +1,22 @@
 #version 450
-layout(location = 0) in vec4 inPos;
+layout(location = 0) in vec4 inPos;     // xyz = position, w = local point spacing
+
+const uint MAX_VIEWS = 8u;
+
+// Written by the host every frame, only the first view is drawn here
+layout(std140, set = 0, binding = 0) uniform Frame {
+    mat4 mvp[MAX_VIEWS];
+    float time;
+} frame;
 
 layout(push_constant) uniform PC {
-    mat4 mvp;
+    float pointSize;
+    float pointScale;       // Pixels per unit at view depth 1; 0 keeps the fixed pointSize
 } pc;
 
 void main() {
-    gl_Position = pc.mvp * inPos;
-    gl_PointSize = 2.0;
+    gl_Position = frame.mvp[0] * vec4(inPos.xyz, 1.0);
+
+    // Adaptive size covers the local spacing between points on screen
+    gl_PointSize = pc.pointScale > 0.0 ? clamp(inPos.w * pc.pointScale / gl_Position.w, 1.0, 16.0) : pc.pointSize;
 }
@@ -0,0 +1,22 @@
+#version 450
+#extension GL_EXT_multiview : require
+
+layout(location = 0) in vec4 inPos;     // xyz = position, w = local point spacing
+
+const uint MAX_VIEWS = 8u;
+
+// One camera per view, indexed by the multiview layer being rendered
+layout(std140, set = 0, binding = 0) uniform Frame {
+    mat4 mvp[MAX_VIEWS];
+    float time;
+} frame;
+
+layout(push_constant) uniform PC {
+    float pointSize;
+    float pointScale;
+} pc;
+
+void main() {
+    gl_Position = frame.mvp[gl_ViewIndex] * vec4(inPos.xyz, 1.0);
+    gl_PointSize = pc.pointScale > 0.0 ? clamp(inPos.w * pc.pointScale / gl_Position.w, 1.0, 16.0) : pc.pointSize;
+}
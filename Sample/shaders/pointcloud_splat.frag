@@ -0,0 +1,12 @@
+#version 450
+
+layout(early_fragment_tests) in;
+
+// rgb = color, a = view depth for the hole-filling pass
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec2 uv = gl_PointCoord * 2.0 - 1.0;
+    vec3 color = vec3(1.0, 0.85, 0.6) * (1.0 - 0.3 * dot(uv, uv));
+    outColor = vec4(color, 1.0 / gl_FragCoord.w);
+}
@@ -8,6 +8,10 @@
 #include "Core/App.h"
 #include "Core/Renderer.h"
 
+// STD
+#include <chrono>
+#include <cstdio>
+
 int main(int argc, char* argv[])
 {
 	App* app = new App();
@@ -17,14 +21,48 @@ int main(int argc, char* argv[])
 	Renderer renderer(window);
 	renderer.LoadMesh("objects/Suzanne.obj");
 	renderer.SetParticleCount(10000);			// Optional - Defaults to 10,000
+	//renderer.SetMemoryBudgetShare(0.5f);			// Optional - Limits particle buffers to half the free device memory budget, defaults to 0.8
 	renderer.SetRotationSpeed(10.0f);			// Optional - Defaults to 10 degrees per second
+	//renderer.SetMaxFramesInFlight(2);			// Optional - Defaults to 2 frames recorded ahead of the GPU
+	//renderer.SetDynamicResolution(true, 16.6f);		// Optional - Scales internal resolution to hold a GPU frame-time budget
+	//renderer.SetDepthTest(true);				// Optional - Depth-tests points, drawing clusters front to back
+	//renderer.SetSplatting(true);				// Optional - Splats points and fills the gaps between them in screen space
+	//renderer.SetMultiview(4);				// Optional - Renders 4 cameras around the mesh in one pass, tiled in the window
+	//renderer.SetViewCamera(1, glm::vec3(0.0f, 3.0f, 0.1f), glm::vec3(0.0f));	// Optional - Looks down on the mesh from view 1 instead of orbiting
+	//renderer.SetPrerecordedCommands(true);		// Optional - Reuses per-image command buffers, writing only uniforms each frame
+	//renderer.SetAsyncCompute(true);			// Optional - Generates particles on a dedicated compute queue alongside rendering
+	//renderer.SetPresentPolicy(PresentPolicy::Throughput);	// Optional - Throughput, LowLatency (default) or PowerSaving presentation
+	//renderer.SetFramePacing(1000.0f / window->GetRefreshRate());	// Optional - Starts frames at the display refresh interval
+	//renderer.SetFixedTimeStep(1000.0f / 60.0f);		// Optional - Advances animation a fixed 60 Hz step per frame for repeatable benchmarks
+	//renderer.SetParallelRecording(8);			// Optional - Records the draw as 8 secondary command buffers on worker threads
+	//renderer.SetMemoryCompaction(true);			// Optional - Moves buffers out of sparsely used memory blocks, 16 MiB per frame
+	//renderer.SetShaderOverrideDirectory("shaders");	// Optional - Loads .spv files from disk instead of the embedded SPIR-V
 	renderer.Init();
+	renderer.StartRenderThread();
 
-	bool running = true;
-	while (running)
+	// Events are handled here while the render thread draws, state changes are forwarded through the renderer's queue
+	float postedDistance = window->CameraDistance;
+	auto lastTitleUpdate = std::chrono::steady_clock::now();
+	while (window->WaitEvents(10))
 	{
-		running = window->PollEvents();
-		renderer.Run();
+		// Frame times and memory use are shown in the window title, refreshed twice a second
+		auto now = std::chrono::steady_clock::now();
+		if (now - lastTitleUpdate >= std::chrono::milliseconds(500))
+		{
+			RendererStats stats = renderer.GetStats();
+			char title[256];
+			std::snprintf(title, sizeof(title), "Point-Collision Renderer - CPU %.2f ms, GPU %.2f ms, %ux%u (%.0f%%), %u particles, %.1f / %.1f MiB device memory",
+				stats.cpuFrameTimeMs, stats.gpuFrameTimeMs, stats.renderExtent.width, stats.renderExtent.height, stats.renderScale * 100.0f,
+				stats.particleCount, stats.deviceMemory.usage / (1024.0 * 1024.0), stats.deviceMemory.budget / (1024.0 * 1024.0));
+			SDL_SetWindowTitle(window->Get(), title);
+			lastTitleUpdate = now;
+		}
+
+		if (window->CameraDistance != postedDistance && renderer.Post({ RenderCommand::Type::CameraDistance, window->CameraDistance }))
+			postedDistance = window->CameraDistance;
+
+		if (window->FramebufferResized && renderer.Post({ RenderCommand::Type::Resize, 0.0f, 0, window->GetWidth(), window->GetHeight() }))
+			window->FramebufferResized = false;
 	}
 
 	renderer.Shutdown();